@@ -0,0 +1,125 @@
+//
+// Created by agent on 2026/10/16.
+//
+// 配置加载开销：生成 keys 个键的 JSON，对比解析 JSON 建索引与映射编译好的快照
+// load 为从打开文件到可以查询的耗时（取多次中的最小值），lookup 为随机键查询（ns/次）
+// 用法: ConfBench [keys]
+//
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include "ConfLoad.h"
+
+using namespace std;
+
+const string kConfPath = "/tmp/framejk_conf_bench.conf";
+ConfLoad* ConfLoad::conf_load_ = nullptr;
+string ConfLoad::conf_dir_ = kConfPath;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kLoadRuns = 5;
+constexpr size_t kLookups = 1000000;
+
+// 每个服务一个对象，含字符串、整数、浮点与布尔各一个键
+void writeConfig(const string& path, size_t keys) {
+    ofstream out(path);
+    out << "{\n";
+    const size_t services = (keys + 3) / 4;
+    for (size_t i = 0; i < services; ++i) {
+        out << "  \"service" << i << "\": {\"host\": \"10.0." << i % 256 << "." << i / 256
+            << "\", \"port\": " << 8000 + i % 1000 << ", \"weight\": " << (i % 100) / 10.0
+            << ", \"enabled\": " << (i % 2 ? "true" : "false") << "}"
+            << (i + 1 < services ? ",\n" : "\n");
+    }
+    out << "}\n";
+}
+
+const ConfIndex* parseJson(const string& path) {
+    const ifstream file(path);
+    stringstream buffer;
+    buffer << file.rdbuf();
+    const string content = buffer.str();
+    cJSON* root = cJSON_Parse(content.c_str());
+    if (root == nullptr) {
+        return nullptr;
+    }
+    const auto* index = new ConfIndex(root, 1);
+    cJSON_Delete(root);
+    return index;
+}
+
+template <typename Load>
+double bestLoadUs(Load&& load) {
+    double best = 1e18;
+    for (int run = 0; run < kLoadRuns; ++run) {
+        const auto start = Clock::now();
+        std::unique_ptr<const ConfIndex> index(load());
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+        if (!index) {
+            return -1;
+        }
+        best = std::min(best, static_cast<double>(ns) / 1000.0);
+    }
+    return best;
+}
+
+double lookupNs(const ConfIndex& index, const std::vector<string>& keys) {
+    uint64_t value = 0x9E3779B97F4A7C15ull;
+    size_t found = 0;
+    const auto start = Clock::now();
+    for (size_t i = 0; i < kLookups; ++i) {
+        value ^= value << 13;
+        value ^= value >> 7;
+        value ^= value << 17;
+        found += index.find(keys[value % keys.size()]) != nullptr;
+    }
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    if (found != kLookups) {
+        printf("lookup mismatch: %zu of %zu\n", found, kLookups);
+    }
+    return static_cast<double>(ns) / kLookups;
+}
+
+}
+
+int main(int argc, char** argv) {
+    const size_t keys = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 40000;
+    writeConfig(kConfPath, keys);
+    std::remove(ConfLoad::snapshotPath().c_str());
+
+    string error;
+    if (!ConfLoad::GetInstance()->compile(error)) {
+        printf("compile failed: %s\n", error.c_str());
+        return 1;
+    }
+    ConfSourceStamp stamp;
+    ConfSourceStamp::of(kConfPath, stamp);
+
+    std::unique_ptr<const ConfIndex> json(parseJson(kConfPath));
+    std::unique_ptr<const ConfIndex> snapshot(ConfIndex::map(ConfLoad::snapshotPath(), 1, &stamp, error));
+    if (!json || !snapshot) {
+        printf("load failed: %s\n", error.c_str());
+        return 1;
+    }
+    std::vector<string> paths;
+    for (const auto& entry : *json) {
+        paths.emplace_back(entry.path());
+    }
+
+    printf("keys=%zu snapshot=%zu bytes\n", json->size(), snapshot->image().size());
+    printf("%-10s load %10.1f us  lookup %6.1f ns\n", "json",
+           bestLoadUs([&] { return parseJson(kConfPath); }), lookupNs(*json, paths));
+    printf("%-10s load %10.1f us  lookup %6.1f ns\n", "snapshot",
+           bestLoadUs([&] { return ConfIndex::map(ConfLoad::snapshotPath(), 1, &stamp, error); }),
+           lookupNs(*snapshot, paths));
+    return 0;
+}
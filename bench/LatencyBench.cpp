@@ -0,0 +1,82 @@
+//
+// Created by agent on 2026/10/16.
+//
+// 延迟直方图的记录与查询开销
+// 记录：LatencyMetrics::record 一次写入排队、执行、总延迟三个直方图（ns/次）
+// clustered 为集中在几十微秒附近的延迟，接近实际负载；spread 均匀分布在 0~4ms，每次落到不同的桶，为缓存最差情况
+// 查询：合并所有线程的直方图并输出文本与 JSON
+// 用法: LatencyBench [iterations] [threads]
+//
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "LatencyHistogram.h"
+
+using namespace std;
+
+SpdLogger* SpdLogger::instance = nullptr;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void measure(const char* name, size_t iterations, size_t threads, uint64_t wait_base, uint64_t wait_mask,
+             uint64_t exec_base, uint64_t exec_mask) {
+    LatencyMetrics metrics(threads);
+    std::vector<double> ns_per_record(threads);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            uint64_t value = 0x9E3779B97F4A7C15ull * (t + 1);
+            const auto start = Clock::now();
+            for (size_t i = 0; i < iterations; ++i) {
+                value ^= value << 13;
+                value ^= value >> 7;
+                value ^= value << 17;
+                const auto priority = static_cast<Priority>(1 + (value & 3));
+                metrics.record(t, priority, wait_base + ((value >> 8) & wait_mask),
+                               exec_base + ((value >> 32) & exec_mask));
+            }
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+            ns_per_record[t] = static_cast<double>(ns) / static_cast<double>(iterations);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double total = 0;
+    for (const double ns : ns_per_record) {
+        total += ns;
+    }
+    printf("%-10s threads=%-3zu record %6.1f ns/call\n", name, threads, total / static_cast<double>(threads));
+}
+
+}
+
+int main(int argc, char** argv) {
+    const size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    const size_t threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+
+    measure("clustered", iterations, 1, 20000, 0xFFF, 50000, 0x3FFF);
+    measure("clustered", iterations, threads, 20000, 0xFFF, 50000, 0x3FFF);
+    measure("spread", iterations, 1, 0, 0xFFFFF, 0, 0x3FFFFF);
+    measure("spread", iterations, threads, 0, 0xFFFFF, 0, 0x3FFFFF);
+
+    // 导出：每个线程若干条记录后合并
+    LatencyMetrics metrics(threads);
+    for (size_t t = 0; t < threads; ++t) {
+        for (uint64_t i = 0; i < 100000; ++i) {
+            metrics.record(t, static_cast<Priority>(1 + i % 4), 1000 + i % 50000, 20000 + (i * 7919) % 200000);
+        }
+    }
+    const auto start = Clock::now();
+    const string text = metrics.toText();
+    const string json = metrics.toJson();
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    printf("export text+json %lld us\n%s%s\n", static_cast<long long>(us), text.c_str(), json.c_str());
+    return 0;
+}
@@ -0,0 +1,105 @@
+//
+// Created by agent on 2026/10/16.
+//
+// 单次 LOG 调用的开销（ns/次），对比原先的 ostringstream 实现
+// 被过滤：运行期最低级别为 INFO 时的 LOG(DEBUG)
+// 仅格式化：构造并填充 LogMessage，不写入 sink
+// 完整路径：LOG(INFO) 同步写入文件 sink
+// 编译期过滤（-DFRAMEJK_LOG_MIN_LEVEL=1）下 LOG(DEBUG) 被整条消除，开销为 0
+// 用法: LogBench [iterations]
+//
+
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include "Logger.h"
+
+using namespace std;
+
+SpdLogger* SpdLogger::instance = nullptr;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 原先的实现：每次调用按字符串比较解析级别，并总是构造 ostringstream，写入前才判断级别
+class LegacyLogMessage {
+public:
+    LegacyLogMessage(LogLevel level, const char* file, int line) : level_(level) {
+        stream_ << "[" << file << ":" << line << "] ";
+    }
+
+    ~LegacyLogMessage() {
+        if (level_ >= LogLevel::INFO) {
+            sink_ += stream_.str().size();
+        }
+    }
+
+    template <typename T>
+    LegacyLogMessage& operator<<(const T& msg) {
+        stream_ << msg;
+        return *this;
+    }
+
+    static std::atomic<size_t> sink_;
+
+private:
+    std::ostringstream stream_;
+    LogLevel level_;
+};
+
+std::atomic<size_t> LegacyLogMessage::sink_{0};
+
+#define LEGACY_LOG(level) LegacyLogMessage(stringToLogLevel(#level), __FILE_NAME__, __LINE__)
+
+template <typename Body>
+void measure(const char* name, size_t iterations, Body&& body) {
+    const auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        body(i);
+    }
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    printf("%-28s %8.1f ns/call\n", name, static_cast<double>(ns) / static_cast<double>(iterations));
+}
+
+}
+
+int main(int argc, char** argv) {
+    const size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+    auto* conf = new LoggerConfig;
+    conf->logPath = "/tmp/framejk_log_bench.log";
+    conf->minLogLevel = LogLevel::INFO;
+    conf->asyncMode = false;
+    conf->consoleOutput = false;
+    SpdLogger::set_config(conf);
+    SpdLogger::GetInstance();
+
+    const uint64_t task_id = 123456789;
+    const double ratio = 0.75;
+
+    measure("legacy disabled DEBUG", iterations, [&](size_t i) {
+        LEGACY_LOG(DEBUG) << "Thread " << i << " completed task " << task_id << " ratio " << ratio;
+    });
+    measure("disabled DEBUG", iterations, [&](size_t i) {
+        LOG(DEBUG) << "Thread " << i << " completed task " << task_id << " ratio " << ratio;
+    });
+
+    measure("legacy format only", iterations, [&](size_t i) {
+        LEGACY_LOG(INFO) << "Thread " << i << " completed task " << task_id << " ratio " << ratio;
+    });
+    measure("format only", iterations, [&](size_t i) {
+        LogMessage(nullptr, LogLevel::INFO, __FILE_NAME__, __LINE__)
+            << "Thread " << i << " completed task " << task_id << " ratio " << ratio;
+    });
+
+    measure("enabled INFO to file", iterations, [&](size_t i) {
+        LOG(INFO) << "Thread " << i << " completed task " << task_id << " ratio " << ratio;
+    });
+
+    printf("checksum %zu\n", LegacyLogMessage::sink_.load());
+    return 0;
+}
@@ -0,0 +1,76 @@
+//
+// Created by agent on 2026/10/16.
+//
+// 文件 sink 吞吐：rotating_file_sink_mt 与 MmapFileSink 对比
+// 同步 logger，单线程与多线程各写固定条数，段大小 kSegmentSize 下会多次轮转
+// flush 一栏为每条都 flush（flush_on(info)）：rotating 每条一次 write()，mmap 不做系统调用
+// 用法: LogSinkBench [messages] [threads] [dir]
+//
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/rotating_file_sink.h>
+#include "MmapLogSink.h"
+
+using namespace std;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kSegmentSize = 16 * 1024 * 1024;
+constexpr size_t kSegments = 4;
+
+void run(const char* name, const spdlog::sink_ptr& sink, size_t messages, size_t threads, bool flush_each) {
+    auto logger = std::make_shared<spdlog::logger>(name, sink);
+    logger->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] %v");
+    if (flush_each) {
+        logger->flush_on(spdlog::level::info);
+    }
+    const size_t per_thread = messages / threads;
+
+    const auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (size_t i = 0; i < per_thread; ++i) {
+                logger->info("[LogSinkBench.cpp:42] Thread {} completed task {} ratio {}", t, i, 0.75);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    logger->flush();
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+    const double seconds = static_cast<double>(ns) / 1e9;
+    const double total = static_cast<double>(per_thread * threads);
+    printf("%-10s threads=%-3zu flush=%-3s %8.1f ns/msg %10.0f msg/s\n",
+           name, threads, flush_each ? "yes" : "no", static_cast<double>(ns) / total, total / seconds);
+}
+
+}
+
+int main(int argc, char** argv) {
+    const size_t messages = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    const size_t threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+    const string dir = argc > 3 ? argv[3] : "/tmp";
+
+    for (const bool flush_each : {false, true}) {
+        for (const size_t n : {static_cast<size_t>(1), threads}) {
+            run("rotating", std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+                dir + "/framejk_sink_bench_rotating.log", kSegmentSize, kSegments), messages, n, flush_each);
+            run("mmap", std::make_shared<MmapFileSink>(
+                dir + "/framejk_sink_bench_mmap.log", kSegmentSize, kSegments,
+                std::chrono::milliseconds(1000), true), messages, n, flush_each);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+//
+// Created by agent on 2026/10/16.
+//
+// 全局队列模式（加锁分桶 / 无锁环形队列 / 批量）与工作窃取模式的吞吐对比
+// 外部提交 roots 个根任务，每个根任务在工作线程内再派生 fanout 个子任务
+// batchSize > 1 时子任务通过 submitBatch 一次提交，工作线程按批取出
+// 用法: PoolBench [threads] [roots] [fanout]
+//
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include "ThreadPool.h"
+
+using namespace std;
+
+SpdLogger* SpdLogger::instance = nullptr;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void run(const char* name, const ThreadPoolConfig& pool_conf, QueueEngine engine,
+         size_t roots, size_t fanout) {
+    const size_t threads = pool_conf.numThreads;
+    const size_t total = roots * (fanout + 1);
+    auto queue = make_shared<PriorityTaskQueue>(total * 2, engine);
+    auto ctx = make_shared<TransCtx>();
+    atomic<size_t> done{0};
+    atomic<size_t> rejected{0};
+
+    ThreadPool pool(pool_conf, queue, ctx);
+    const auto start = Clock::now();
+    for (size_t i = 0; i < roots; ++i) {
+        Task root([&](const shared_ptr<TransCtx>&) {
+            if (pool_conf.batchSize > 1) {
+                vector<Task> children;
+                children.reserve(fanout);
+                for (size_t k = 0; k < fanout; ++k) {
+                    children.emplace_back([&](const shared_ptr<TransCtx>&) { ++done; });
+                }
+                rejected += pool.submitBatch(children).rejected;
+            } else {
+                for (size_t k = 0; k < fanout; ++k) {
+                    if (!pool.submit(Task([&](const shared_ptr<TransCtx>&) { ++done; }))) {
+                        ++rejected;
+                    }
+                }
+            }
+            ++done;
+        }, Priority::CRITICAL);
+        if (!pool.submit(std::move(root))) {
+            rejected += fanout + 1;
+        }
+    }
+    const auto deadline = start + std::chrono::seconds(30);
+    while (done.load() + rejected.load() < total && Clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    const double sec = std::chrono::duration<double>(Clock::now() - start).count();
+    pool.stop();
+
+    printf("%-14s threads=%-3zu tasks=%-9zu done=%-9zu %8.3f s %8.2f Mtasks/s\n",
+           name, threads, total, done.load(), sec, static_cast<double>(done.load()) / sec / 1e6);
+}
+
+}
+
+int main(const int argc, char** argv) {
+    auto* conf = new LoggerConfig;
+    conf->logPath = "/tmp/framejk_bench.log";
+    conf->minLogLevel = LogLevel::WARN;
+    conf->consoleOutput = false;
+    SpdLogger::set_config(conf);
+
+    const size_t threads = argc > 1 ? strtoull(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    const size_t roots = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000;
+    const size_t fanout = argc > 3 ? strtoull(argv[3], nullptr, 10) : 100;
+
+    ThreadPoolConfig pool_conf;
+    pool_conf.numThreads = threads;
+    run("global-queue", pool_conf, QueueEngine::BUCKET, roots, fanout);
+    run("global-ring", pool_conf, QueueEngine::RING, roots, fanout);
+
+    pool_conf.batchSize = 32;
+    run("global-batch", pool_conf, QueueEngine::BUCKET, roots, fanout);
+    run("ring-batch", pool_conf, QueueEngine::RING, roots, fanout);
+
+    pool_conf.batchSize = 1;
+    pool_conf.mode = SchedulerMode::WORK_STEALING;
+    run("work-stealing", pool_conf, QueueEngine::BUCKET, roots, fanout);
+    return 0;
+}
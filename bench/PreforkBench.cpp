@@ -0,0 +1,197 @@
+//
+// Created by agent on 2026/10/16.
+//
+// CPU 密集任务下线程模式与预派生模式的吞吐对比，两种模式使用同一个共享内存任务通道
+// threaded 为本进程消费通道，ThreadPool 开 workers 个线程执行
+// prefork 为 PreforkMaster 派生 workers 个工作进程，各自一个线程，共同消费通道
+// 每个任务做 work 次整数运算；fork 出的生产者进程全速写入通道，通道满时让出 CPU 重试
+// 用法: PreforkBench [workers] [messages] [work] [producers]
+//
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "Prefork.h"
+
+using namespace std;
+
+SpdLogger* SpdLogger::instance = nullptr;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kQueueSize = 1024;
+constexpr int kCtrlShareId = 40;
+
+// 不可被编译器消除的整数运算
+uint64_t burn(uint64_t seed, size_t work) {
+    uint64_t x = seed | 1;
+    for (size_t i = 0; i < work; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    return x;
+}
+
+std::atomic<uint64_t> sink{0};
+
+ShmTaskConsumer::Handler makeHandler(size_t work) {
+    return [work](uint32_t type, std::string_view, const shared_ptr<TransCtx>&) {
+        sink.fetch_xor(burn(type, work), std::memory_order_relaxed);
+    };
+}
+
+// 子进程中只使用共享内存，不碰父进程的线程与日志
+[[noreturn]] void produce(int channel_id, size_t messages, size_t producer) {
+    ShmTaskProducer channel(channel_id);
+    if (!channel.valid()) {
+        _exit(1);
+    }
+    const char payload[8] = {};
+    for (size_t i = 0; i < messages; ++i) {
+        while (!channel.submit(static_cast<uint32_t>(producer * messages + i), Priority::CRITICAL,
+                               std::string_view(payload, sizeof(payload)))) {
+            std::this_thread::yield();
+        }
+    }
+    _exit(0);
+}
+
+std::vector<pid_t> forkProducers(int channel_id, size_t producers, size_t messages) {
+    std::vector<pid_t> children;
+    for (size_t p = 0; p < producers; ++p) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            produce(channel_id, messages, p);
+        }
+        if (pid > 0) {
+            children.push_back(pid);
+        }
+    }
+    return children;
+}
+
+void report(const char* name, size_t workers, size_t total, size_t done, size_t dropped, double sec) {
+    printf("%-10s workers=%-3zu msgs=%-8zu done=%-8zu dropped=%-6zu %7.3f s %9.0f tasks/s\n",
+           name, workers, total, done, dropped, sec, static_cast<double>(done) / sec);
+}
+
+double runThreaded(size_t workers, size_t producers, size_t messages, size_t work) {
+    const int channel_id = static_cast<int>(getpid() & 0xFFFF) * 16 + 2;
+    const size_t total = producers * messages;
+    auto queue = make_shared<PriorityTaskQueue>(kQueueSize, QueueEngine::RING);
+    atomic<size_t> done{0};
+    atomic<size_t> expired{0};
+    queue->setExpiryCallback([&](Task&) { expired.fetch_add(1, std::memory_order_relaxed); });
+    const auto handler = makeHandler(work);
+    ShmTaskConsumer consumer(channel_id, queue, [&](uint32_t type, std::string_view payload,
+                                                    const shared_ptr<TransCtx>& ctx) {
+        handler(type, payload, ctx);
+        done.fetch_add(1, std::memory_order_relaxed);
+    });
+    if (!consumer.valid()) {
+        printf("%-10s shared memory unavailable\n", "threaded");
+        return 0;
+    }
+
+    // 先 fork 再启动线程，子进程中只有一个线程
+    const auto start = Clock::now();
+    const auto children = forkProducers(channel_id, producers, messages);
+    ThreadPoolConfig pool_conf;
+    pool_conf.numThreads = workers;
+    pool_conf.latencyMetrics = false;
+    ThreadPool pool(pool_conf, queue, make_shared<TransCtx>());
+    consumer.start();
+
+    const auto deadline = start + std::chrono::seconds(120);
+    while (done.load(std::memory_order_relaxed) + expired.load(std::memory_order_relaxed) < total
+           && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    const double sec = std::chrono::duration<double>(Clock::now() - start).count();
+    for (const pid_t pid : children) {
+        waitpid(pid, nullptr, 0);
+    }
+    consumer.stop();
+    consumer.remove();
+    pool.stop();
+    report("threaded", workers, total, done.load(), expired.load(), sec);
+    return static_cast<double>(done.load()) / sec;
+}
+
+double runPrefork(size_t workers, size_t producers, size_t messages, size_t work) {
+    const int channel_id = static_cast<int>(getpid() & 0xFFFF) * 16 + 3;
+    const size_t total = producers * messages;
+    ShareOptions ctrl_options;
+    ctrl_options.backend = ShareBackend::POSIX;
+    CreateShare<CtrlShared> ctrl(kCtrlShareId, OWN_RW_OTH_N, "/tmp", ctrl_options);
+    if (!ctrl.valid()) {
+        printf("%-10s control segment unavailable\n", "prefork");
+        return 0;
+    }
+    PreforkConfig conf;
+    conf.workers = workers;
+    conf.threadsPerWorker = 1;
+    conf.channelId = channel_id;
+    PreforkMaster master(conf, *ctrl.get(), makeHandler(work));
+
+    // zygote 须在本进程创建任何线程之前 fork，所以先于 runThreaded 运行（其中的日志写线程不会退出）
+    if (!master.prepare()) {
+        printf("%-10s failed to fork zygote\n", "prefork");
+        return 0;
+    }
+    const auto start = Clock::now();
+    const auto children = forkProducers(channel_id, producers, messages);
+    if (!master.start()) {
+        printf("%-10s failed to start workers\n", "prefork");
+        return 0;
+    }
+
+    const auto deadline = start + std::chrono::seconds(120);
+    while (master.completed() + master.dropped() < total && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    const double sec = std::chrono::duration<double>(Clock::now() - start).count();
+    for (const pid_t pid : children) {
+        waitpid(pid, nullptr, 0);
+    }
+    const size_t done = master.completed();
+    const size_t dropped = master.dropped();
+    master.stop();
+    master.remove();
+    ctrl.remove();
+    report("prefork", workers, total, done, dropped, sec);
+    return static_cast<double>(done) / sec;
+}
+
+}
+
+int main(const int argc, char** argv) {
+    auto* conf = new LoggerConfig;
+    conf->logPath = "/tmp/framejk_bench.log";
+    conf->minLogLevel = LogLevel::WARN;
+    conf->consoleOutput = false;
+    SpdLogger::set_config(conf);
+
+    const size_t workers = argc > 1 ? strtoull(argv[1], nullptr, 10) : std::max(std::thread::hardware_concurrency(), 1u);
+    const size_t messages = argc > 2 ? strtoull(argv[2], nullptr, 10) : 100000;
+    const size_t work = argc > 3 ? strtoull(argv[3], nullptr, 10) : 20000;
+    const size_t producers = argc > 4 ? std::max<size_t>(strtoull(argv[4], nullptr, 10), 1) : 1;
+
+    const double prefork = runPrefork(workers, producers, messages, work);
+    const double threaded = runThreaded(workers, producers, messages, work);
+    if (threaded > 0) {
+        printf("prefork/threaded %.2f\n", prefork / threaded);
+    }
+    return 0;
+}
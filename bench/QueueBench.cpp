@@ -0,0 +1,98 @@
+//
+// Created by agent on 2026/10/16.
+//
+// 分桶队列 TaskLanes 与原评分堆 TaskHeap 的吞吐对比
+// 用法: QueueBench [max_depth]，默认依次测试 10k / 100k / 1M 排队任务
+//
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "TaskQueue.h"
+
+using namespace std;
+
+SpdLogger* SpdLogger::instance = nullptr;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+vector<Task> makeTasks(size_t n) {
+    static const Priority priorities[] = {
+        Priority::LOW, Priority::NORMAL, Priority::HIGH, Priority::CRITICAL
+    };
+    vector<Task> tasks;
+    tasks.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        tasks.emplace_back([](const shared_ptr<TransCtx>&) {}, priorities[i % 4]);
+    }
+    return tasks;
+}
+
+double mopsPerSec(size_t ops, Clock::duration elapsed) {
+    const double sec = std::chrono::duration<double>(elapsed).count();
+    return sec > 0 ? static_cast<double>(ops) / sec / 1e6 : 0.0;
+}
+
+// 三个阶段：填充 n 个任务、排空 n 个任务、深度保持 n 时的 push+pop 稳态
+template <typename Store>
+void run(const char* name, Store& store, size_t n) {
+    auto tasks = makeTasks(n);
+    Task task;
+
+    auto start = Clock::now();
+    for (auto& t : tasks) {
+        store.push(std::move(t));
+    }
+    const auto fill = Clock::now() - start;
+
+    start = Clock::now();
+    for (size_t i = 0; i < n; ++i) {
+        store.pop(task);
+        store.push(std::move(task));
+    }
+    const auto steady = Clock::now() - start;
+
+    start = Clock::now();
+    size_t drained = 0;
+    while (store.pop(task)) {
+        ++drained;
+    }
+    const auto drain = Clock::now() - start;
+
+    printf("%-8s depth=%-8zu push %8.2f Mops/s | push+pop %8.2f Mops/s | pop %8.2f Mops/s (%zu)\n",
+           name, n, mopsPerSec(n, fill), mopsPerSec(n, steady), mopsPerSec(n, drain), drained);
+}
+
+}
+
+int main(const int argc, char** argv) {
+    const size_t max_depth = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+    for (size_t depth = 10000; depth <= max_depth; depth *= 10) {
+        {
+            TaskHeap heap;
+            run("heap", heap, depth);
+        }
+        {
+            // 老化阈值置 0，避免晋升路径干扰纯出入队的对比
+            AgingPolicy no_aging;
+            no_aging.promote_after.fill(std::chrono::milliseconds(0));
+            TaskLanes lanes(no_aging);
+            run("bucket", lanes, depth);
+        }
+        {
+            // 打开晋升：LOW 100ms、NORMAL 250ms
+            AgingPolicy aging;
+            aging.promote_after[priorityToLane(Priority::LOW)] = std::chrono::milliseconds(100);
+            aging.promote_after[priorityToLane(Priority::NORMAL)] = std::chrono::milliseconds(250);
+            TaskLanes lanes(aging);
+            run("bucket+a", lanes, depth);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+//
+// Created by agent on 2026/10/16.
+//
+// 跨进程任务通道：fork 出的生产者进程写入共享内存环，本进程的消费线程推入 PriorityTaskQueue，一个工作线程执行
+// throughput 为各生产者全速发送（环满时让出 CPU 重试），统计消息/秒
+// paced 为单个生产者每隔 interval 微秒发一条，消费者大部分时间睡在 futex 上，反映唤醒延迟
+// 延迟为生产者写入前到工作线程执行之间的时间，负载中携带发送时刻，工作线程只有一个，直方图单写者
+// 队列容量有限，工作线程跟不上时反压到共享内存环；按优先级默认超时到期的任务计入 expired
+// 用法: ShmChannelBench [producers] [messages] [interval_us]
+//
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "LatencyHistogram.h"
+#include "ShmTaskChannel.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+SpdLogger* SpdLogger::instance = nullptr;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kQueueSize = 4096;
+
+int64_t nowNs() {
+    return Clock::now().time_since_epoch().count();
+}
+
+// 子进程中只使用共享内存与 steady_clock，不碰父进程的线程与日志
+[[noreturn]] void produce(int channel_id, size_t messages, size_t producer, std::chrono::microseconds interval) {
+    ShmTaskProducer channel(channel_id);
+    if (!channel.valid()) {
+        _exit(1);
+    }
+    char payload[16] = {};
+    auto next = Clock::now();
+    for (size_t i = 0; i < messages; ++i) {
+        if (interval.count() > 0) {
+            next += interval;
+            while (Clock::now() < next) {
+                cpuRelax();
+            }
+        }
+        const auto priority = static_cast<Priority>(1 + (producer + i) % 4);
+        while (true) {
+            const int64_t sent = nowNs();
+            std::memcpy(payload, &sent, sizeof(sent));
+            if (channel.submit(static_cast<uint32_t>(producer), priority, std::string_view(payload, sizeof(payload)))) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+    _exit(0);
+}
+
+void run(const char* name, size_t producers, size_t messages, std::chrono::microseconds interval) {
+    const int channel_id = static_cast<int>(getpid() & 0xFFFF) * 16 + static_cast<int>(interval.count() > 0);
+    const size_t total = producers * messages;
+    auto queue = make_shared<PriorityTaskQueue>(kQueueSize, QueueEngine::RING);
+    auto ctx = make_shared<TransCtx>();
+    LatencyHistogram latency;
+    atomic<size_t> done{0};
+    atomic<size_t> expired{0};
+    queue->setExpiryCallback([&](Task&) { expired.fetch_add(1, std::memory_order_release); });
+
+    ShmTaskConsumer consumer(channel_id, queue, [&](uint32_t, std::string_view payload, const shared_ptr<TransCtx>&) {
+        int64_t sent = 0;
+        std::memcpy(&sent, payload.data(), sizeof(sent));
+        latency.record(static_cast<uint64_t>(std::max<int64_t>(nowNs() - sent, 0)));
+        done.fetch_add(1, std::memory_order_release);
+    });
+    if (!consumer.valid()) {
+        printf("%-10s shared memory unavailable\n", name);
+        return;
+    }
+
+    // 先 fork 再启动线程，子进程中只有一个线程
+    const auto start = Clock::now();
+    std::vector<pid_t> children;
+    for (size_t p = 0; p < producers; ++p) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            produce(channel_id, messages, p, interval);
+        }
+        if (pid > 0) {
+            children.push_back(pid);
+        }
+    }
+
+    ThreadPoolConfig pool_conf;
+    pool_conf.numThreads = 1;
+    ThreadPool pool(pool_conf, queue, ctx);
+    consumer.start();
+
+    const auto deadline = start + std::chrono::seconds(60);
+    while (done.load(std::memory_order_acquire) + expired.load(std::memory_order_acquire) < total
+           && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    const double sec = std::chrono::duration<double>(Clock::now() - start).count();
+    for (const pid_t pid : children) {
+        waitpid(pid, nullptr, 0);
+    }
+    consumer.stop();
+    consumer.remove();
+    pool.stop();
+
+    LatencySnapshot snap;
+    latency.mergeInto(snap);
+    printf("%-10s producers=%-3zu msgs=%-9zu done=%-9zu %7.3f s %9.0f msgs/s  "
+           "p50=%" PRIu64 "ns p99=%" PRIu64 "ns p999=%" PRIu64 "ns max=%" PRIu64 "ns full=%" PRIu64 " expired=%zu\n",
+           name, producers, total, done.load(), sec, static_cast<double>(done.load()) / sec,
+           snap.percentile(0.5), snap.percentile(0.99), snap.percentile(0.999), snap.max,
+           consumer.ring().fullCount(), expired.load());
+}
+
+}
+
+int main(const int argc, char** argv) {
+    auto* conf = new LoggerConfig;
+    conf->logPath = "/tmp/framejk_bench.log";
+    conf->minLogLevel = LogLevel::WARN;
+    conf->consoleOutput = false;
+    SpdLogger::set_config(conf);
+
+    const size_t producers = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4;
+    const size_t messages = argc > 2 ? strtoull(argv[2], nullptr, 10) : 250000;
+    const auto interval = std::chrono::microseconds(argc > 3 ? strtoull(argv[3], nullptr, 10) : 100);
+
+    run("throughput", producers, messages, std::chrono::microseconds(0));
+    run("paced", 1, std::min<size_t>(messages, 20000), interval);
+    return 0;
+}
@@ -0,0 +1,198 @@
+//
+// Created by agent on 2026/10/16.
+//
+// 统计提交 -> 执行路径上的堆分配次数
+// 对比原先 shared_ptr<Task> + std::function 的表示与按值保存的 Task
+// 线程池一项包含 runTask 中每个任务一条 DEBUG 日志的开销
+// 128B 线程池一项为跨线程回收：提交线程分配的块在工作线程释放后回到提交线程
+//
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <queue>
+#include <thread>
+#include "ThreadPool.h"
+
+using namespace std;
+
+SpdLogger* SpdLogger::instance = nullptr;
+
+namespace {
+
+std::atomic<uint64_t> g_allocs{0};
+
+}
+
+void* operator new(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// 与上面的 malloc 配对，GCC 无法识别替换后的全局 operator new
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+namespace {
+
+constexpr size_t kOps = 100000;
+
+// 原先的任务表示：每次提交 make_shared + std::function，执行时按值复制上下文
+struct LegacyTask {
+    std::function<void(shared_ptr<TransCtx>)> func;
+    Priority priority;
+};
+
+// 48 字节闭包，模拟常见的捕获几个指针和整数的 lambda
+struct Payload {
+    uint64_t a, b, c, d, e, f;
+};
+
+// 128 字节闭包，超出内联缓冲区，走 TaskBlockPool
+struct BigPayload {
+    uint64_t words[16];
+};
+
+void report(const char* name, uint64_t allocs, size_t ops) {
+    printf("%-28s %8.3f allocs/task\n", name, static_cast<double>(allocs) / static_cast<double>(ops));
+}
+
+template <typename Body>
+uint64_t countAllocs(Body&& body) {
+    const uint64_t before = g_allocs.load();
+    body();
+    return g_allocs.load() - before;
+}
+
+}
+
+int main() {
+    auto* conf = new LoggerConfig;
+    conf->logPath = "/tmp/framejk_bench.log";
+    conf->minLogLevel = LogLevel::WARN;
+    conf->consoleOutput = false;
+    SpdLogger::set_config(conf);
+    SpdLogger::GetInstance();
+
+    auto ctx = make_shared<TransCtx>();
+    uint64_t sink = 0;
+    Payload payload{1, 2, 3, 4, 5, 6};
+    BigPayload big{};
+
+    // 原表示
+    {
+        std::priority_queue<shared_ptr<LegacyTask>, vector<shared_ptr<LegacyTask>>,
+            std::function<bool(const shared_ptr<LegacyTask>&, const shared_ptr<LegacyTask>&)>> heap(
+            [](const shared_ptr<LegacyTask>& a, const shared_ptr<LegacyTask>& b) {
+                return a->priority < b->priority;
+            });
+        const uint64_t allocs = countAllocs([&] {
+            for (size_t i = 0; i < kOps; ++i) {
+                heap.push(make_shared<LegacyTask>(LegacyTask{
+                    [payload, &sink](shared_ptr<TransCtx>) { sink += payload.a; }, Priority::HIGH}));
+                auto task = heap.top();
+                heap.pop();
+                task->func(ctx);
+            }
+        });
+        report("legacy shared_ptr+function", allocs, kOps);
+    }
+
+    // 按值 Task + 队列，预热后统计
+    for (auto engine : {QueueEngine::BUCKET, QueueEngine::RING}) {
+        PriorityTaskQueue queue(kOps, engine);
+        auto cycle = [&] {
+            for (size_t i = 0; i < kOps; ++i) {
+                queue.push(Task([payload, &sink](const shared_ptr<TransCtx>&) { sink += payload.a; }));
+                auto task = queue.pop();
+                task->execute(ctx);
+            }
+        };
+        cycle();
+        report(engine == QueueEngine::BUCKET ? "value task, bucket queue" : "value task, ring queue",
+               countAllocs(cycle), kOps);
+    }
+
+    // 超出内联大小的闭包
+    {
+        PriorityTaskQueue queue(kOps);
+        auto cycle = [&] {
+            for (size_t i = 0; i < kOps; ++i) {
+                queue.push(Task([big, &sink](const shared_ptr<TransCtx>&) { sink += big.words[0]; }));
+                auto task = queue.pop();
+                task->execute(ctx);
+            }
+        };
+        cycle();
+        report("value task, 128B capture", countAllocs(cycle), kOps);
+    }
+
+    // 经过线程池：主线程提交，工作线程执行
+    {
+        auto queue = make_shared<PriorityTaskQueue>(kOps * 2);
+        ThreadPool pool(1, queue, ctx);
+        std::atomic<size_t> done{0};
+        auto cycle = [&] {
+            const size_t target = done.load() + kOps;
+            for (size_t i = 0; i < kOps; ++i) {
+                while (!pool.submit(Task([payload, &done](const shared_ptr<TransCtx>&) {
+                    done.fetch_add(payload.a > 0 ? 1 : 0);
+                }))) {
+                    std::this_thread::yield();
+                }
+            }
+            while (done.load() < target) {
+                std::this_thread::yield();
+            }
+        };
+        cycle();
+        report("value task, thread pool", countAllocs(cycle), kOps);
+        pool.stop();
+    }
+
+    // 超出内联大小的闭包经过线程池：主线程分配的块在工作线程释放，经 remote 栈回到主线程
+    // 每次最多 kWindow 个任务在途，在途的块总要分配，窗口之外的应全部复用
+    {
+        constexpr size_t kWindow = 250;
+        auto queue = make_shared<PriorityTaskQueue>(kOps * 2);
+        ThreadPool pool(1, queue, ctx);
+        std::atomic<size_t> done{0};
+        auto cycle = [&] {
+            for (size_t i = 0; i < kOps; i += kWindow) {
+                const size_t target = done.load() + kWindow;
+                for (size_t j = 0; j < kWindow; ++j) {
+                    while (!pool.submit(Task([big, &done](const shared_ptr<TransCtx>&) {
+                        done.fetch_add(big.words[0] == 0 ? 1 : 0);
+                    }))) {
+                        std::this_thread::yield();
+                    }
+                }
+                while (done.load() < target) {
+                    std::this_thread::yield();
+                }
+            }
+        };
+        cycle();
+        report("128B capture, thread pool", countAllocs(cycle), kOps);
+        pool.stop();
+    }
+
+    printf("checksum %llu\n", static_cast<unsigned long long>(sink));
+    return 0;
+}
@@ -0,0 +1,84 @@
+//
+// Created by agent on 2026/10/16.
+//
+// 时间轮在不同挂起定时器数量下的插入、取消与推进开销
+// 用法: TimerBench [max_timers]
+//
+
+#include <string>
+#include <memory>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "TimerWheel.h"
+
+using namespace std;
+
+SpdLogger* SpdLogger::instance = nullptr;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double nsPerOp(Clock::time_point start, size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(ops);
+}
+
+void run(size_t timers) {
+    const auto t0 = Clock::now();
+    TimerWheel wheel(t0);
+    std::mt19937_64 rng(42);
+    // 大部分在一分钟内，少量跨到更高层
+    std::uniform_int_distribution<int64_t> near_ms(1, 60000);
+    std::uniform_int_distribution<int64_t> far_ms(60000, 86400000);
+    std::vector<TimerHandle> handles;
+    handles.reserve(timers);
+    uint64_t sink = 0;
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < timers; ++i) {
+        const int64_t delay = (i % 10 == 0) ? far_ms(rng) : near_ms(rng);
+        handles.push_back(wheel.addOnce(t0, std::chrono::milliseconds(delay),
+            [&sink](const shared_ptr<TransCtx>&) { ++sink; }, Priority::NORMAL));
+    }
+    const double insert_ns = nsPerOp(start, timers);
+
+    start = Clock::now();
+    size_t cancelled = 0;
+    for (size_t i = 1; i < timers; i += 2) {
+        cancelled += wheel.cancel(handles[i]) ? 1 : 0;
+    }
+    const double cancel_ns = nsPerOp(start, cancelled);
+
+    // 推进两分钟，按 1ms 步长模拟定时线程
+    std::vector<Task> fired;
+    size_t expired = 0;
+    start = Clock::now();
+    for (int64_t ms = 1; ms <= 120000; ++ms) {
+        wheel.advance(t0 + std::chrono::milliseconds(ms), fired);
+        expired += fired.size();
+        fired.clear();
+    }
+    const double advance_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    printf("timers=%-9zu insert %7.1f ns  cancel %7.1f ns  advance 120k ticks %8.2f ms  expired=%zu pending=%zu\n",
+           timers, insert_ns, cancel_ns, advance_ms, expired, wheel.size());
+}
+
+}
+
+int main(const int argc, char** argv) {
+    auto* conf = new LoggerConfig;
+    conf->logPath = "/tmp/framejk_bench.log";
+    conf->minLogLevel = LogLevel::WARN;
+    conf->consoleOutput = false;
+    SpdLogger::set_config(conf);
+
+    const size_t max_timers = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    for (size_t timers = 10000; timers <= max_timers; timers *= 10) {
+        run(timers);
+    }
+    return 0;
+}
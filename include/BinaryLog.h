@@ -0,0 +1,439 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_BINARYLOG_H
+#define FRAME_BINARYLOG_H
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// 二进制日志：调用点的文件、行号、级别和参数类型只登记一次，每条日志只保存时间戳与参数原始字节
+// 文件格式（本机字节序）：
+//   文件头  "FJKBLOG1"
+//   'S' 调用点定义  u32 id, u32 line, u8 level, u16 file_len, file, u8 argc, 参数类型标记[argc]
+//   'R' 日志记录    i64 time_ns, u16 payload_len, payload
+// payload 为 u32 调用点 id, u8 实际参数个数, 各参数按类型编码；实际个数少于定义时表示被截断
+// 每个文件开头会重新写出其后用到的调用点定义，单个文件可独立解码
+
+// 参数类型标记
+enum LogArgTag : char {
+    LOG_ARG_BOOL = 'b',     // u8
+    LOG_ARG_CHAR = 'c',     // char
+    LOG_ARG_INT = 'i',      // i64
+    LOG_ARG_UINT = 'u',     // u64
+    LOG_ARG_DOUBLE = 'd',   // double
+    LOG_ARG_STRING = 's',   // u16 长度 + 字节
+    LOG_ARG_POINTER = 'p',  // u64
+    LOG_ARG_SUPPRESSED = 'x'    // u64，限流宏压制的次数，为 0 时不输出
+};
+
+constexpr char kBinaryLogMagic[8] = {'F', 'J', 'K', 'B', 'L', 'O', 'G', '1'};
+constexpr size_t kBinaryPayloadHeader = sizeof(uint32_t) + sizeof(uint8_t);
+constexpr size_t kBinaryMaxArgs = 32;
+
+// 调用点静态信息，常量初始化，没有首次调用的加锁开销；首次以二进制模式输出时登记得到 id
+struct LogSite {
+    const char* file;
+    int line;
+    int level;
+    std::atomic<uint32_t> id;
+
+    constexpr LogSite(const char* site_file, int site_line, int site_level)
+        : file(site_file), line(site_line), level(site_level), id(0) {}
+};
+
+struct LogSiteInfo {
+    std::string file;
+    uint32_t line = 0;
+    uint8_t level = 0;
+    std::string signature;      // 参数类型标记序列
+};
+
+// 进程内的调用点表，id 从 1 开始
+class LogSiteRegistry {
+public:
+    uint32_t registerSite(LogSite& site, std::string_view signature) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (const uint32_t id = site.id.load(std::memory_order_acquire)) {
+            return id;
+        }
+        LogSiteInfo info;
+        info.file = site.file;
+        info.line = static_cast<uint32_t>(site.line);
+        info.level = static_cast<uint8_t>(site.level);
+        info.signature = std::string(signature);
+        sites_.push_back(std::move(info));
+        const auto id = static_cast<uint32_t>(sites_.size());
+        site.id.store(id, std::memory_order_release);
+        return id;
+    }
+
+    bool lookup(uint32_t id, LogSiteInfo& out) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (id == 0 || id > sites_.size()) {
+            return false;
+        }
+        out = sites_[id - 1];
+        return true;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<LogSiteInfo> sites_;
+};
+
+inline LogSiteRegistry& logSiteRegistry() {
+    static LogSiteRegistry registry;
+    return registry;
+}
+
+// 按大小滚动的二进制日志文件，命名同 path, path.1, ..., path.max_files
+// 非线程安全，只由日志写线程使用
+class BinaryLogFile {
+public:
+    BinaryLogFile(std::string path, size_t max_size, size_t max_files)
+        : path_(std::move(path))
+        , max_size_(max_size)
+        , max_files_(max_files)
+        , file_(nullptr)
+        , size_(0) {
+        open();
+    }
+
+    ~BinaryLogFile() {
+        if (file_) {
+            std::fclose(file_);
+        }
+    }
+
+    BinaryLogFile(const BinaryLogFile &) = delete;
+    void operator=(const BinaryLogFile &) = delete;
+
+    void write(int64_t time_ns, const char* payload, size_t len) {
+        if (!file_ || len < kBinaryPayloadHeader || len > UINT16_MAX) {
+            return;
+        }
+        uint32_t site_id;
+        std::memcpy(&site_id, payload, sizeof(site_id));
+        LogSiteInfo site;
+        bool have_site = false;
+        if (!siteWritten(site_id)) {
+            if (!logSiteRegistry().lookup(site_id, site)) {
+                return;
+            }
+            have_site = true;
+        }
+
+        const size_t record_size = 1 + sizeof(int64_t) + sizeof(uint16_t) + len;
+        const size_t site_size = have_site ? siteSize(site) : 0;
+        if (max_size_ > 0 && size_ + record_size + site_size > max_size_ && size_ > sizeof(kBinaryLogMagic)) {
+            rotate();
+            if (!file_) {
+                return;
+            }
+        }
+        if (!siteWritten(site_id)) {
+            if (!have_site && !logSiteRegistry().lookup(site_id, site)) {
+                return;
+            }
+            writeSite(site_id, site);
+        }
+        putByte('R');
+        put(&time_ns, sizeof(time_ns));
+        const auto payload_len = static_cast<uint16_t>(len);
+        put(&payload_len, sizeof(payload_len));
+        put(payload, len);
+    }
+
+    void flush() {
+        if (file_) {
+            std::fflush(file_);
+        }
+    }
+
+private:
+    [[nodiscard]] bool siteWritten(uint32_t id) const {
+        return id < written_sites_.size() && written_sites_[id];
+    }
+
+    static size_t siteSize(const LogSiteInfo& site) {
+        return 1 + 4 + 4 + 1 + 2 + site.file.size() + 1 + site.signature.size();
+    }
+
+    void writeSite(uint32_t id, const LogSiteInfo& site) {
+        putByte('S');
+        put(&id, sizeof(id));
+        put(&site.line, sizeof(site.line));
+        putByte(static_cast<char>(site.level));
+        const auto file_len = static_cast<uint16_t>(site.file.size());
+        put(&file_len, sizeof(file_len));
+        put(site.file.data(), file_len);
+        putByte(static_cast<char>(site.signature.size()));
+        put(site.signature.data(), site.signature.size());
+        if (id >= written_sites_.size()) {
+            written_sites_.resize(id + 1, false);
+        }
+        written_sites_[id] = true;
+    }
+
+    void open() {
+        file_ = std::fopen(path_.c_str(), "wb");
+        size_ = 0;
+        written_sites_.clear();
+        if (!file_) {
+            std::fprintf(stderr, "Failed to open binary log [%s]\n", path_.c_str());
+            return;
+        }
+        put(kBinaryLogMagic, sizeof(kBinaryLogMagic));
+    }
+
+    // path -> path.1 -> ... -> path.max_files，最旧的被删除
+    void rotate() {
+        std::fclose(file_);
+        file_ = nullptr;
+        if (max_files_ > 0) {
+            std::remove(rotatedName(max_files_).c_str());
+            for (size_t i = max_files_; i > 1; --i) {
+                std::rename(rotatedName(i - 1).c_str(), rotatedName(i).c_str());
+            }
+            std::rename(path_.c_str(), rotatedName(1).c_str());
+        }
+        open();
+    }
+
+    std::string rotatedName(size_t index) const {
+        return path_ + "." + std::to_string(index);
+    }
+
+    void putByte(char c) {
+        put(&c, 1);
+    }
+
+    void put(const void* data, size_t n) {
+        std::fwrite(data, 1, n, file_);
+        size_ += n;
+    }
+
+    std::string path_;
+    size_t max_size_;
+    size_t max_files_;
+    FILE* file_;
+    size_t size_;
+    std::vector<bool> written_sites_;
+};
+
+// 解码二进制日志文件为文本，格式同文本日志 [%Y-%m-%d %H:%M:%S.%e] [%l] [file:line] 消息
+class BinaryLogReader {
+public:
+    explicit BinaryLogReader(const std::string& path) : file_(std::fopen(path.c_str(), "rb")) {
+        char magic[sizeof(kBinaryLogMagic)];
+        if (file_ && (std::fread(magic, 1, sizeof(magic), file_) != sizeof(magic)
+                      || std::memcmp(magic, kBinaryLogMagic, sizeof(magic)) != 0)) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    ~BinaryLogReader() {
+        if (file_) {
+            std::fclose(file_);
+        }
+    }
+
+    BinaryLogReader(const BinaryLogReader &) = delete;
+    void operator=(const BinaryLogReader &) = delete;
+
+    [[nodiscard]] bool valid() const { return file_ != nullptr; }
+
+    // 读出下一条日志，文件结束或损坏时返回 false
+    bool next(std::string& line) {
+        int kind;
+        while (file_ && (kind = std::fgetc(file_)) != EOF) {
+            if (kind == 'S') {
+                if (!readSite()) {
+                    return false;
+                }
+            } else if (kind == 'R') {
+                return readRecord(line);
+            } else {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    static const char* levelName(uint8_t level) {
+        static const char* const kNames[] = {"debug", "info", "warning", "error", "critical"};
+        return level < 5 ? kNames[level] : "unknown";
+    }
+
+private:
+    template <typename T>
+    bool get(T& value) {
+        return std::fread(&value, sizeof(T), 1, file_) == 1;
+    }
+
+    bool readSite() {
+        uint32_t id;
+        LogSiteInfo site;
+        uint16_t file_len;
+        uint8_t argc;
+        if (!get(id) || !get(site.line) || !get(site.level) || !get(file_len)) {
+            return false;
+        }
+        site.file.resize(file_len);
+        if (std::fread(site.file.data(), 1, file_len, file_) != file_len || !get(argc)) {
+            return false;
+        }
+        site.signature.resize(argc);
+        if (std::fread(site.signature.data(), 1, argc, file_) != argc) {
+            return false;
+        }
+        if (id >= sites_.size()) {
+            sites_.resize(id + 1);
+        }
+        sites_[id] = std::move(site);
+        return true;
+    }
+
+    bool readRecord(std::string& line) {
+        int64_t time_ns;
+        uint16_t len;
+        if (!get(time_ns) || !get(len) || len < kBinaryPayloadHeader) {
+            return false;
+        }
+        payload_.resize(len);
+        if (std::fread(payload_.data(), 1, len, file_) != len) {
+            return false;
+        }
+        uint32_t site_id;
+        std::memcpy(&site_id, payload_.data(), sizeof(site_id));
+        const auto argc = static_cast<uint8_t>(payload_[sizeof(site_id)]);
+        if (site_id >= sites_.size() || sites_[site_id].file.empty()) {
+            return false;
+        }
+        const LogSiteInfo& site = sites_[site_id];
+
+        line.clear();
+        appendTime(line, time_ns);
+        line += " [";
+        line += levelName(site.level);
+        line += "] [";
+        line += site.file;
+        line += ":";
+        line += std::to_string(site.line);
+        line += "] ";
+
+        size_t pos = kBinaryPayloadHeader;
+        for (size_t i = 0; i < argc && i < site.signature.size(); ++i) {
+            if (!appendArg(line, site.signature[i], pos)) {
+                return false;
+            }
+        }
+        if (argc < site.signature.size()) {
+            line += "...";
+        }
+        return true;
+    }
+
+    template <typename T>
+    bool take(T& value, size_t& pos) const {
+        if (pos + sizeof(T) > payload_.size()) {
+            return false;
+        }
+        std::memcpy(&value, payload_.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool appendArg(std::string& line, char tag, size_t& pos) const {
+        char text[32];
+        switch (tag) {
+            case LOG_ARG_BOOL: {
+                uint8_t v;
+                if (!take(v, pos)) return false;
+                line += v ? '1' : '0';
+                return true;
+            }
+            case LOG_ARG_CHAR: {
+                char v;
+                if (!take(v, pos)) return false;
+                line += v;
+                return true;
+            }
+            case LOG_ARG_INT: {
+                int64_t v;
+                if (!take(v, pos)) return false;
+                std::snprintf(text, sizeof(text), "%" PRId64, v);
+                break;
+            }
+            case LOG_ARG_UINT: {
+                uint64_t v;
+                if (!take(v, pos)) return false;
+                std::snprintf(text, sizeof(text), "%" PRIu64, v);
+                break;
+            }
+            case LOG_ARG_DOUBLE: {
+                double v;
+                if (!take(v, pos)) return false;
+                std::snprintf(text, sizeof(text), "%g", v);
+                break;
+            }
+            case LOG_ARG_POINTER: {
+                uint64_t v;
+                if (!take(v, pos)) return false;
+                std::snprintf(text, sizeof(text), "0x%" PRIx64, v);
+                break;
+            }
+            case LOG_ARG_SUPPRESSED: {
+                uint64_t v;
+                if (!take(v, pos)) return false;
+                if (v > 0) {
+                    line += "[suppressed " + std::to_string(v) + "] ";
+                }
+                return true;
+            }
+            case LOG_ARG_STRING: {
+                uint16_t n;
+                if (!take(n, pos) || pos + n > payload_.size()) return false;
+                line.append(payload_.data() + pos, n);
+                pos += n;
+                return true;
+            }
+            default:
+                return false;
+        }
+        line += text;
+        return true;
+    }
+
+    // 本地时间，毫秒精度
+    static void appendTime(std::string& line, int64_t time_ns) {
+        const time_t seconds = static_cast<time_t>(time_ns / 1000000000);
+        const int millis = static_cast<int>((time_ns / 1000000) % 1000);
+        std::tm tm{};
+        localtime_r(&seconds, &tm);
+        char text[64];
+        std::snprintf(text, sizeof(text), "[%04d-%02d-%02d %02d:%02d:%02d.%03d]",
+                      tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                      tm.tm_hour, tm.tm_min, tm.tm_sec, millis);
+        line += text;
+    }
+
+    FILE* file_;
+    std::vector<LogSiteInfo> sites_;
+    std::vector<char> payload_;
+};
+
+#endif //FRAME_BINARYLOG_H
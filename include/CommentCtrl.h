@@ -8,71 +8,376 @@
 #include <string>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <csignal>
+#include <climits>
+#include <thread>
 #include <utility>
 #include <Logger.h>
+#include <CreateShare.h>
+#include <Futex.h>
 
 using namespace std;
 
+// 程序控制：-start 启动服务并监听命令，-stop / -set / -ping 通过共享内存邮箱发给运行中的进程
+// 运行中的进程由 pid 文件确定，控制段中记录的 pid 必须与之一致
 class CommentCtrl{
 public:
+    // 处理 -set，返回 false 时 message 为拒绝原因
+    using SetHandler = std::function<bool(const string& key, const string& value, string& message)>;
+
+    static constexpr int kShareId = 1;
+
     CommentCtrl(CommentCtrl &other) = delete;
     void operator=(const CommentCtrl &) = delete;
-    static CommentCtrl *GetInstance(string pid_path) {
-        return nullptr;
+    static CommentCtrl *GetInstance(string pid_path, string share_path = "/tmp") {
+        if (comment_ctrl_ == nullptr) {
+            comment_ctrl_ = new CommentCtrl(std::move(pid_path), std::move(share_path));
+        }
+        return comment_ctrl_;
+    }
+
+    // 服务端：open 后 listen；必须在任何线程之前完成的准备（如预派生的 zygote）放在两者之间
+    // SIGTERM 与 SIGINT 按 -stop 处理
+    bool start(SetHandler on_set) {
+        if (!open()) {
+            return false;
+        }
+        listen(std::move(on_set));
+        return true;
+    }
+
+    // 服务端：检查 pid 文件，建立控制段，写入本进程 pid；已有存活的进程时返回 false
+    // 不创建线程，成功时也不写日志（第一次写日志会创建日志线程）
+    bool open() {
+        // 检查 pid 文件是否存在
+        if (const pid_t pid = loadPid(); pid > 0 && pid != getpid() && kill(pid, 0) == 0) {
+            LOG(INFO) << "Process is already running, pid " << pid;
+            return false;
+        }
+        share_ = openShare();
+        if (!share_->valid()) {
+            LOG(ERROR) << "Control segment unavailable under " << share_path_;
+            return false;
+        }
+        if (!share_->created()) {
+            // 上一个进程没有正常退出，段中可能留有未完成的命令
+            share_->remove();
+            share_ = openShare();
+        }
+        if (!savePid()) {
+            LOG(ERROR) << "Failed to write pid file " << pid_path_ << ": " << strerror(errno);
+            share_->remove();
+            return false;
+        }
+        CtrlShared& shared = *share_->get();
+        shared.serverPid.store(static_cast<uint32_t>(getpid()), std::memory_order_release);
+        shared.running = true;
+        return true;
+    }
+
+    // 服务端：open 成功后开始监听命令
+    void listen(SetHandler on_set) {
+        on_set_ = std::move(on_set);
+        std::signal(SIGTERM, onSignal);
+        std::signal(SIGINT, onSignal);
+        listener_ = std::thread([this]() { this->serve(); });
+        LOG(INFO) << "Control listening on " << share_->name() << ", pid file " << pid_path_;
+    }
+
+    // 服务端：阻塞到收到停止命令或信号
+    void waitForStop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return stopping_; });
+    }
+
+    // 服务端：最多等待 timeout，收到停止命令或信号时返回 true
+    bool waitForStop(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, timeout, [this]() { return stopping_; });
+    }
+
+    // 服务端：控制段，open 成功后有效，fork 出的子进程共享同一映射
+    CtrlShared* shared() const {
+        return share_ ? share_->get() : nullptr;
+    }
+
+    // 服务端：排空结束后调用，回复 -stop 的客户端，停止监听，删除 pid 文件与控制段
+    // 日志此时可能已经关闭，这里不再写日志
+    void finishStop(bool ok, const string& message) {
+        if (!share_) {
+            return;
+        }
+        CtrlShared& shared = *share_->get();
+        listener_stop_ = true;
+        futexWake(shared.request, INT_MAX);
+        if (listener_.joinable()) {
+            listener_.join();
+        }
+        shared.running = false;
+        shared.serverPid.store(0, std::memory_order_release);
+        if (stop_seq_ != 0) {
+            reply(shared, stop_seq_, ok ? 0 : 1, message);
+        }
+        std::error_code error;
+        std::filesystem::remove(pid_path_, error);
+        share_->remove();
+    }
+
+    // 服务端：-ping 时返回的运行参数
+    void publishConfig(std::string_view text) {
+        if (share_) {
+            share_->get()->setConfig(text);
+        }
     }
+
+    // 客户端：停止运行中的进程，等待其排空后回复
+    bool stop(string& result, std::chrono::milliseconds timeout = std::chrono::seconds(60)) {
+        return send(CtrlOp::STOP, "", "", result, timeout);
+    }
+
+    // 客户端：运行中调整参数
+    bool set(const string& key, const string& value, string& result) {
+        return send(CtrlOp::SET, key, value, result, kReplyTimeout);
+    }
+
+    // 客户端：查询运行状态
+    bool ping(string& result) {
+        return send(CtrlOp::PING, "", "", result, kReplyTimeout);
+    }
+
+    // 帮助
+    static void help(const char* program) {
+        std::cout << "Usage: " << program << " <command>\n"
+                  << "  -start                   run in foreground, controlled by the commands below\n"
+                  << "  -stop                    stop admissions, drain queued tasks, flush logs and exit\n"
+                  << "  -set <key> <value>       change a runtime setting:\n"
+                  << "                           pool.threads, pool.minThreads, pool.maxThreads, logger.minLevel\n"
+                  << "  -ping                    show pid and current settings\n"
+                  << "  -stats [ms] [rounds]     print live stats of the running process\n"
+                  << "  -compile [out]           compile the config snapshot\n";
+    }
+
 protected:
-    explicit CommentCtrl(string pid_path) : pid_path_(std::move(pid_path)){
+    CommentCtrl(string pid_path, string share_path)
+        : pid_path_(std::move(pid_path)), share_path_(std::move(share_path)) {}
 
+    ~CommentCtrl() {
+        listener_stop_ = true;
+        if (listener_.joinable()) {
+            futexWake(share_->get()->request, INT_MAX);
+            listener_.join();
+        }
     }
-    ~CommentCtrl();
+
 private:
+    static constexpr std::chrono::milliseconds kReplyTimeout{5000};
+    static constexpr std::chrono::milliseconds kPoll{200};
+
     [[nodiscard]] bool fileExists() const {
         return std::filesystem::exists(pid_path_);
     }
 
-    void savePid() const {
-        if(!fileExists()) {
-            LOG(DEBUG) << "pid path is no exist";
-            throw runtime_error("pid path is no exist");
-        }
-        std::ofstream pidFile(pid_path_);
+    [[nodiscard]] bool savePid() const {
+        std::ofstream pidFile(pid_path_, std::ios::trunc);
         pidFile << getpid();
         pidFile.close();
+        return static_cast<bool>(pidFile);
     }
 
+    // pid 文件不存在或无法解析时返回 0；open 在预派生的 zygote 之前调用，这里不写日志
     [[nodiscard]] pid_t loadPid() const {
         if(!fileExists()) {
-            LOG(DEBUG) << "pid path is no exist";
-            throw runtime_error("pid path is no exist");
+            return 0;
         }
         std::ifstream pidFile(pid_path_);
-        pid_t pid;
+        pid_t pid = 0;
         pidFile >> pid;
         pidFile.close();
         return pid;
     }
-    // 程序控制
-    // 启动
-    bool start() {
-        // 检查 pid 文件是否存在
-        if (fileExists()) {
-            LOG(INFO) << "Process is already running";
-            return false;
+
+    [[nodiscard]] std::unique_ptr<CreateShare<CtrlShared>> openShare() const {
+        ShareOptions options;
+        options.backend = ShareBackend::POSIX;
+        return std::make_unique<CreateShare<CtrlShared>>(kShareId, OWN_RW_OTH_N, share_path_, options);
+    }
+
+    static void onSignal(int) {
+        stop_signal_ = 1;
+    }
+
+    // 监听线程：睡在 request 上，客户端写好命令后唤醒；信号标志在每次超时醒来时检查
+    void serve() {
+        CtrlShared& shared = *share_->get();
+        uint32_t seen = shared.request.load(std::memory_order_acquire);
+        while (!listener_stop_) {
+            futexWait(shared.request, seen, kPoll);
+            if (stop_signal_) {
+                stop_signal_ = 0;
+                beginStop(0);
+            }
+            const uint32_t seq = shared.request.load(std::memory_order_acquire);
+            if (seq == seen) {
+                continue;
+            }
+            seen = seq;
+            const CtrlCommand command = shared.command;
+            handle(shared, command, seq);
         }
-        return true;
     }
 
-    // 停止
-    void stop() {
+    void handle(CtrlShared& shared, const CtrlCommand& command, uint32_t seq) {
+        const string key(command.key, strnlen(command.key, sizeof(command.key)));
+        const string value(command.value, strnlen(command.value, sizeof(command.value)));
+        bool stopping;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping = stopping_;
+        }
+        switch (command.op) {
+            case CtrlOp::PING:
+                reply(shared, seq, 0, "pid " + std::to_string(getpid()) + (stopping ? " stopping" : " running")
+                                      + (shared.getConfig().empty() ? "" : ", " + shared.getConfig()));
+                break;
+            case CtrlOp::SET: {
+                if (stopping) {
+                    reply(shared, seq, 1, "process is stopping");
+                    break;
+                }
+                string message;
+                const bool ok = on_set_ && on_set_(key, value, message);
+                LOG(INFO) << "Control set " << key << "=" << value << (ok ? " applied" : " rejected: " + message);
+                reply(shared, seq, ok ? 0 : 1, message);
+                break;
+            }
+            case CtrlOp::STOP:
+                if (stopping) {
+                    reply(shared, seq, 1, "process is already stopping");
+                    break;
+                }
+                // 排空完成后由 finishStop 回复
+                LOG(INFO) << "Control stop requested";
+                beginStop(seq);
+                break;
+            default:
+                reply(shared, seq, 1, "unknown command");
+                break;
+        }
+    }
 
+    void beginStop(uint32_t seq) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                return;
+            }
+            stopping_ = true;
+            stop_seq_ = seq;
+        }
+        cv_.notify_all();
+    }
+
+    static void reply(CtrlShared& shared, uint32_t seq, int status, const string& message) {
+        shared.reply.status = status;
+        const size_t length = std::min(message.size(), sizeof(shared.reply.message) - 1);
+        std::memcpy(shared.reply.message, message.data(), length);
+        shared.reply.message[length] = '\0';
+        shared.replied.store(seq, std::memory_order_release);
+        futexWake(shared.replied, INT_MAX);
     }
-    // 帮助
-    void help() {
 
+    // 客户端发送：核对 pid 文件与控制段，取得邮箱，写命令，等待同一序号的回复
+    bool send(CtrlOp op, const string& key, const string& value, string& result,
+              std::chrono::milliseconds timeout) {
+        const pid_t pid = loadPid();
+        if (pid <= 0 || kill(pid, 0) != 0) {
+            result = "process is not running (pid file " + pid_path_ + ")";
+            return false;
+        }
+        const auto share = openShare();
+        if (!share->valid()) {
+            result = "control segment unavailable";
+            return false;
+        }
+        CtrlShared& shared = *share->get();
+        if (shared.serverPid.load(std::memory_order_acquire) != static_cast<uint32_t>(pid)) {
+            result = "control segment belongs to pid " + std::to_string(shared.serverPid.load())
+                     + ", pid file says " + std::to_string(pid);
+            return false;
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        if (!acquireMailbox(shared, deadline)) {
+            result = "control mailbox is busy";
+            return false;
+        }
+        shared.command.op = op;
+        std::memset(shared.command.key, 0, sizeof(shared.command.key));
+        std::memset(shared.command.value, 0, sizeof(shared.command.value));
+        std::memcpy(shared.command.key, key.data(), std::min(key.size(), sizeof(shared.command.key) - 1));
+        std::memcpy(shared.command.value, value.data(), std::min(value.size(), sizeof(shared.command.value) - 1));
+        const uint32_t seq = shared.request.fetch_add(1, std::memory_order_acq_rel) + 1;
+        futexWake(shared.request, 1);
+
+        bool ok = false;
+        while (true) {
+            const uint32_t replied = shared.replied.load(std::memory_order_acquire);
+            if (replied == seq) {
+                result.assign(shared.reply.message, strnlen(shared.reply.message, sizeof(shared.reply.message)));
+                ok = shared.reply.status == 0;
+                break;
+            }
+            if (kill(pid, 0) != 0) {
+                result = op == CtrlOp::STOP ? "process exited" : "process exited before replying";
+                ok = op == CtrlOp::STOP;
+                break;
+            }
+            if (std::chrono::steady_clock::now() >= deadline) {
+                result = "timed out waiting for reply";
+                break;
+            }
+            futexWait(shared.replied, replied, kPoll);
+        }
+        shared.owner.store(0, std::memory_order_release);
+        return ok;
+    }
+
+    // 邮箱一次只给一个客户端；持有者已退出时接管
+    static bool acquireMailbox(CtrlShared& shared, std::chrono::steady_clock::time_point deadline) {
+        const auto self = static_cast<uint32_t>(getpid());
+        while (true) {
+            uint32_t owner = 0;
+            if (shared.owner.compare_exchange_strong(owner, self, std::memory_order_acq_rel)) {
+                return true;
+            }
+            if (kill(static_cast<pid_t>(owner), 0) != 0
+                && shared.owner.compare_exchange_strong(owner, self, std::memory_order_acq_rel)) {
+                return true;
+            }
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
     }
 
     string pid_path_;
+    string share_path_;
+    std::unique_ptr<CreateShare<CtrlShared>> share_;
+    SetHandler on_set_;
+    std::thread listener_;
+    std::atomic<bool> listener_stop_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    uint32_t stop_seq_ = 0;
+    inline static volatile std::sig_atomic_t stop_signal_ = 0;
     static CommentCtrl* comment_ctrl_;
 };
 
-#endif //FRAME_COMMENT_CTRL_H
\ No newline at end of file
+#endif //FRAME_COMMENT_CTRL_H
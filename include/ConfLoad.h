@@ -5,59 +5,535 @@
 #ifndef FRAME_CONFLOAD_H
 #define FRAME_CONFLOAD_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
 #include <Tool.h>
 #include "fstream"
 #include <cjson/cJSON.h>
 using namespace std;
 
-class ConfLoad {
-protected:
-    cJSON* conf_cjson_;
-    static ConfLoad* conf_load_;
-    static std::string conf_dir_;
-    // 获取对应的节点
-    cJSON* get_node(string &key) const {
-        vector<string> keys;
-        spilt_string(key, ".", keys);
-        if (keys.empty()) {
+// 配置值类型，对象与数组只作为路径的一部分，不单独存值
+enum class ConfType : uint8_t {
+    NONE,
+    BOOL,
+    NUMBER,
+    STRING
+};
+
+// 路径哈希，按 ASCII 小写计算，与 cJSON_GetObjectItem 的大小写不敏感匹配保持一致
+inline uint64_t confKeyHash(std::string_view key) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c : key) {
+        const auto lower = static_cast<unsigned char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+        hash = (hash ^ lower) * 1099511628211ull;
+    }
+    return hash;
+}
+
+inline bool confKeyEqual(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        const char x = a[i] >= 'A' && a[i] <= 'Z' ? static_cast<char>(a[i] - 'A' + 'a') : a[i];
+        const char y = b[i] >= 'A' && b[i] <= 'Z' ? static_cast<char>(b[i] - 'A' + 'a') : b[i];
+        if (x != y) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 一个叶子配置项，path 为完整点分路径，数组元素以下标为一段，如 servers.0.host
+// 定长记录，字符串按相对本条目的偏移引用映像中的字符串区，写入文件再映射回来后仍然有效
+struct ConfEntry {
+    uint64_t hash;
+    double number;
+    int32_t integer;
+    uint32_t pathOffset;
+    uint32_t pathSize;
+    uint32_t textOffset;
+    uint32_t textSize;
+    ConfType type;
+    bool boolean;
+
+    [[nodiscard]] std::string_view path() const {
+        return {reinterpret_cast<const char*>(this) + pathOffset, pathSize};
+    }
+
+    [[nodiscard]] std::string_view text() const {
+        return {reinterpret_cast<const char*>(this) + textOffset, textSize};
+    }
+};
+
+// 配置源文件的大小与修改时间，编译快照时记录，加载时不一致即视为快照过期
+struct ConfSourceStamp {
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+
+    static bool of(const string& path, ConfSourceStamp& out) {
+        struct stat st{};
+        if (stat(path.c_str(), &st) != 0) {
+            return false;
+        }
+#ifdef __APPLE__
+        const struct timespec mtime = st.st_mtimespec;
+#else
+        const struct timespec mtime = st.st_mtim;
+#endif
+        out.size = static_cast<uint64_t>(st.st_size);
+        out.mtimeNs = static_cast<int64_t>(mtime.tv_sec) * 1000000000 + mtime.tv_nsec;
+        return true;
+    }
+
+    bool operator==(const ConfSourceStamp& other) const {
+        return size == other.size && mtimeNs == other.mtimeNs;
+    }
+};
+
+// 索引映像头，映像布局为 [头][ConfEntry x entryCount][uint32 槽位 x slotCount][字符串区]
+// 内存中与快照文件中的布局完全相同，整数为本机字节序
+struct ConfImageHeader {
+    static constexpr char kMagic[8] = {'F', 'J', 'K', 'C', 'O', 'N', 'F', '\0'};
+    static constexpr uint32_t kVersion = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t entrySize;         // sizeof(ConfEntry)，布局不同的构建不会误读
+    uint32_t entryCount;
+    uint32_t slotCount;         // 2 的幂
+    uint64_t totalSize;
+    ConfSourceStamp source;
+};
+
+// 扁平化的配置：按完整路径建立开放寻址哈希索引，建好后不可变
+// 从 JSON 构建时映像在自有内存中；从编译好的快照加载时直接映射文件，查询在映射上进行，不做解析
+// 每次重新加载生成一个新的 ConfIndex，generation 依次递增
+class ConfIndex {
+public:
+    ConfIndex(const cJSON* root, uint32_t generation, const ConfSourceStamp& source = ConfSourceStamp())
+        : generation_(generation) {
+        std::vector<FlatEntry> flat;
+        string path;
+        flatten(root, path, flat);
+        build(flat, source);
+    }
+
+    ~ConfIndex() {
+        if (mapped_) {
+            munmap(mapped_, mapped_size_);
+        }
+    }
+
+    ConfIndex(const ConfIndex &) = delete;
+    void operator=(const ConfIndex &) = delete;
+
+    // 映射快照文件；文件不存在、格式不符或与 source 记录不一致时返回 nullptr 并填写 error
+    // source 为空时不检查是否过期
+    // 只校验头部与文件长度，不逐条检查，快照应由 compile 以 rename 原子写入
+    static const ConfIndex* map(const string& file, uint32_t generation,
+                                const ConfSourceStamp* source, string& error) {
+        const int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error = "open " + file + " failed";
+            return nullptr;
+        }
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ConfImageHeader)) {
+            close(fd);
+            error = file + " is not a config snapshot";
+            return nullptr;
+        }
+        const auto size = static_cast<size_t>(st.st_size);
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            error = "mmap " + file + " failed";
+            return nullptr;
+        }
+        const auto* header = static_cast<const ConfImageHeader*>(data);
+        if (!validHeader(*header, size)) {
+            munmap(data, size);
+            error = file + " is not a config snapshot";
+            return nullptr;
+        }
+        if (source && !(header->source == *source)) {
+            munmap(data, size);
+            error = file + " is stale";
             return nullptr;
         }
-        cJSON* section_obj = conf_cjson_;
-        for (const auto & key_unit : keys) {
-            section_obj= cJSON_GetObjectItem(section_obj, key_unit.c_str());
-            if (!section_obj) {
-                return nullptr;
+        auto* index = new ConfIndex(generation);
+        index->mapped_ = data;
+        index->mapped_size_ = size;
+        index->attach(static_cast<const char*>(data));
+        return index;
+    }
+
+    [[nodiscard]] const ConfEntry* find(std::string_view path) const {
+        return find(path, confKeyHash(path));
+    }
+
+    [[nodiscard]] const ConfEntry* find(std::string_view path, uint64_t hash) const {
+        const size_t mask = header_->slotCount - 1;
+        for (size_t slot = hash & mask; slots_[slot] != 0; slot = (slot + 1) & mask) {
+            const ConfEntry& entry = entries_[slots_[slot] - 1];
+            if (entry.hash == hash && confKeyEqual(entry.path(), path)) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] size_t size() const { return header_->entryCount; }
+    [[nodiscard]] const ConfEntry* begin() const { return entries_; }
+    [[nodiscard]] const ConfEntry* end() const { return entries_ + header_->entryCount; }
+    [[nodiscard]] uint32_t generation() const { return generation_; }
+    [[nodiscard]] bool mapped() const { return mapped_ != nullptr; }
+    [[nodiscard]] const ConfSourceStamp& source() const { return header_->source; }
+
+    // 完整映像，原样写入文件即为快照
+    [[nodiscard]] std::string_view image() const {
+        return {reinterpret_cast<const char*>(header_), static_cast<size_t>(header_->totalSize)};
+    }
+
+private:
+    struct FlatEntry {
+        string path;
+        uint64_t hash;
+        ConfType type;
+        bool boolean;
+        int integer;
+        double number;
+        string text;
+    };
+
+    explicit ConfIndex(uint32_t generation) : generation_(generation) {}
+
+    static bool validHeader(const ConfImageHeader& header, size_t size) {
+        if (std::memcmp(header.magic, ConfImageHeader::kMagic, sizeof(header.magic)) != 0
+            || header.version != ConfImageHeader::kVersion
+            || header.entrySize != sizeof(ConfEntry)
+            || header.totalSize != size
+            || header.slotCount == 0
+            || (header.slotCount & (header.slotCount - 1)) != 0
+            || header.entryCount >= header.slotCount) {
+            return false;
+        }
+        const uint64_t tables = sizeof(ConfImageHeader)
+            + static_cast<uint64_t>(header.entryCount) * sizeof(ConfEntry)
+            + static_cast<uint64_t>(header.slotCount) * sizeof(uint32_t);
+        return tables <= size;
+    }
+
+    void attach(const char* base) {
+        header_ = reinterpret_cast<const ConfImageHeader*>(base);
+        entries_ = reinterpret_cast<const ConfEntry*>(base + sizeof(ConfImageHeader));
+        slots_ = reinterpret_cast<const uint32_t*>(entries_ + header_->entryCount);
+    }
+
+    // 先在槽位表中去重，再按布局一次写出整个映像
+    void build(std::vector<FlatEntry>& flat, const ConfSourceStamp& source) {
+        size_t capacity = 16;
+        while (capacity < flat.size() * 2) {
+            capacity <<= 1;
+        }
+        std::vector<uint32_t> slots(capacity, 0);
+        std::vector<const FlatEntry*> unique;
+        unique.reserve(flat.size());
+        size_t strings = 0;
+        for (const auto& entry : flat) {
+            size_t slot = entry.hash & (capacity - 1);
+            bool duplicate = false;
+            while (slots[slot] != 0) {
+                const FlatEntry& existing = *unique[slots[slot] - 1];
+                if (existing.hash == entry.hash && confKeyEqual(existing.path, entry.path)) {
+                    // 大小写不同的重复键与 cJSON_GetObjectItem 一样取第一个
+                    duplicate = true;
+                    break;
+                }
+                slot = (slot + 1) & (capacity - 1);
+            }
+            if (!duplicate) {
+                unique.push_back(&entry);
+                slots[slot] = static_cast<uint32_t>(unique.size());
+                strings += entry.path.size() + entry.text.size();
+            }
+        }
+
+        const size_t entries_at = sizeof(ConfImageHeader);
+        const size_t slots_at = entries_at + unique.size() * sizeof(ConfEntry);
+        const size_t strings_at = slots_at + capacity * sizeof(uint32_t);
+        const size_t total = strings_at + strings;
+        // 以 8 字节为单位分配，保证条目中 double 与 uint64_t 对齐
+        owned_.assign((total + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+        char* base = reinterpret_cast<char*>(owned_.data());
+
+        auto* header = reinterpret_cast<ConfImageHeader*>(base);
+        std::memcpy(header->magic, ConfImageHeader::kMagic, sizeof(header->magic));
+        header->version = ConfImageHeader::kVersion;
+        header->entrySize = sizeof(ConfEntry);
+        header->entryCount = static_cast<uint32_t>(unique.size());
+        header->slotCount = static_cast<uint32_t>(capacity);
+        header->totalSize = total;
+        header->source = source;
+
+        auto* entries = reinterpret_cast<ConfEntry*>(base + entries_at);
+        size_t cursor = strings_at;
+        for (size_t i = 0; i < unique.size(); ++i) {
+            const FlatEntry& from = *unique[i];
+            ConfEntry& to = entries[i];
+            const size_t at = entries_at + i * sizeof(ConfEntry);
+            to.hash = from.hash;
+            to.number = from.number;
+            to.integer = from.integer;
+            to.type = from.type;
+            to.boolean = from.boolean;
+            to.pathOffset = static_cast<uint32_t>(cursor - at);
+            to.pathSize = static_cast<uint32_t>(from.path.size());
+            std::memcpy(base + cursor, from.path.data(), from.path.size());
+            cursor += from.path.size();
+            to.textOffset = static_cast<uint32_t>(cursor - at);
+            to.textSize = static_cast<uint32_t>(from.text.size());
+            std::memcpy(base + cursor, from.text.data(), from.text.size());
+            cursor += from.text.size();
+        }
+        std::memcpy(base + slots_at, slots.data(), capacity * sizeof(uint32_t));
+        attach(base);
+    }
+
+    static void flatten(const cJSON* node, string& path, std::vector<FlatEntry>& out) {
+        if (cJSON_IsObject(node) || cJSON_IsArray(node)) {
+            const size_t base = path.size();
+            size_t index = 0;
+            for (const cJSON* child = node->child; child; child = child->next, ++index) {
+                if (base > 0) {
+                    path += '.';
+                }
+                path += cJSON_IsArray(node) ? std::to_string(index) : string(child->string ? child->string : "");
+                flatten(child, path, out);
+                path.resize(base);
+            }
+            return;
+        }
+        if (path.empty()) {
+            return;
+        }
+        FlatEntry entry{path, confKeyHash(path), ConfType::NONE, false, 0, 0.0, string()};
+        if (cJSON_IsBool(node)) {
+            entry.type = ConfType::BOOL;
+            entry.boolean = cJSON_IsTrue(node);
+        } else if (cJSON_IsNumber(node)) {
+            entry.type = ConfType::NUMBER;
+            entry.integer = node->valueint;
+            entry.number = node->valuedouble;
+        } else if (cJSON_IsString(node)) {
+            entry.type = ConfType::STRING;
+            entry.text = node->valuestring;
+        } else {
+            return;
+        }
+        out.push_back(std::move(entry));
+    }
+
+    std::vector<uint64_t> owned_;       // 从 JSON 构建时的映像
+    void* mapped_ = nullptr;            // 从快照加载时的映射
+    size_t mapped_size_ = 0;
+    const ConfImageHeader* header_ = nullptr;
+    const ConfEntry* entries_ = nullptr;
+    const uint32_t* slots_ = nullptr;   // 条目下标 + 1，0 表示空槽
+    uint32_t generation_;
+};
+
+// 配置快照的 RCU 读者登记
+// 每个读线程占一个缓存行对齐的槽位，读期间写入当前纪元，读完清零；读路径只有两次原子写，不加锁
+// 写者换上新快照后推进纪元，等所有槽位离开旧纪元后再释放旧快照
+// 槽位用完时退化为共享计数，仍然无锁
+class ConfEpoch {
+public:
+    static constexpr size_t kSlots = 128;
+
+    class ReadGuard {
+    public:
+        explicit ReadGuard(ConfEpoch& epoch) : epoch_(epoch) { epoch_.enter(); }
+        ~ReadGuard() { epoch_.leave(); }
+        ReadGuard(const ReadGuard &) = delete;
+        void operator=(const ReadGuard &) = delete;
+    private:
+        ConfEpoch& epoch_;
+    };
+
+    // 写者调用：返回时此前进入的读者都已离开
+    void synchronize() {
+        const uint64_t target = epoch_.fetch_add(1) + 1;
+        for (auto& slot : slots_) {
+            uint64_t seen = slot.epoch.load();
+            while (seen != 0 && seen < target) {
+                std::this_thread::yield();
+                seen = slot.epoch.load();
+            }
+        }
+        while (overflow_readers_.load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{0};
+        std::atomic<bool> used{false};
+    };
+
+    // 线程退出时归还槽位；ConfLoad 为进程级单例，线程局部状态不区分实例
+    struct ThreadState {
+        ConfEpoch* owner = nullptr;
+        Slot* slot = nullptr;
+        size_t depth = 0;
+        bool overflow = false;
+
+        ~ThreadState() {
+            if (slot) {
+                slot->used.store(false);
+            }
+        }
+    };
+
+    static ThreadState& threadState() {
+        thread_local ThreadState state;
+        return state;
+    }
+
+    void enter() {
+        ThreadState& state = threadState();
+        if (state.depth++ > 0) {
+            // 嵌套读取沿用最外层登记的纪元
+            return;
+        }
+        if (state.owner != this) {
+            state.owner = this;
+            state.slot = acquireSlot();
+        }
+        if (state.slot) {
+            state.slot->epoch.store(epoch_.load());
+        } else {
+            state.overflow = true;
+            overflow_readers_.fetch_add(1);
+        }
+    }
+
+    void leave() {
+        ThreadState& state = threadState();
+        if (--state.depth > 0) {
+            return;
+        }
+        if (state.overflow) {
+            state.overflow = false;
+            overflow_readers_.fetch_sub(1);
+        } else if (state.slot) {
+            state.slot->epoch.store(0);
+        }
+    }
+
+    Slot* acquireSlot() {
+        for (auto& slot : slots_) {
+            bool expected = false;
+            if (!slot.used.load(std::memory_order_relaxed)
+                && slot.used.compare_exchange_strong(expected, true)) {
+                return &slot;
             }
         }
-        return section_obj;
+        return nullptr;
     }
 
+    Slot slots_[kSlots];
+    std::atomic<uint64_t> epoch_{1};
+    std::atomic<size_t> overflow_readers_{0};
+};
+
+// 重新加载结果回调：ok 为 false 时 message 为失败原因，新配置未生效
+using ConfReloadCallback = std::function<void(bool ok, const string& message)>;
+// 配置变更监听：参数为本次变化（新增、删除或值改变）的完整路径
+using ConfListener = std::function<void(const std::vector<string>& changed)>;
+// 校验新配置，返回 false 并填写 error 时拒绝本次加载
+using ConfValidator = std::function<bool(const ConfIndex& next, string& error)>;
+
+template <typename T>
+class ConfKey;
+
+class ConfLoad {
+protected:
+    std::atomic<const ConfIndex*> index_{nullptr};
+    mutable ConfEpoch epoch_;
+    static ConfLoad* conf_load_;
+    static std::string conf_dir_;
+
     // 加载配置
     explicit ConfLoad() {
-        const ifstream file(conf_dir_);
-        if (!file.is_open()) {
+        string error;
+        const ConfIndex* index = loadFile(1, error);
+        if (index == nullptr) {
             // 日志
             throw runtime_error("加载失败");
         }
+        index_.store(index);
+    }
+
+    // 快照未过期时直接映射，否则解析 JSON；只有快照而没有 JSON 文件时也使用快照
+    static const ConfIndex* loadFile(uint32_t generation, string& error) {
+        ConfSourceStamp stamp;
+        const bool has_source = ConfSourceStamp::of(conf_dir_, stamp);
+        string snapshot_error;
+        if (const ConfIndex* index = ConfIndex::map(snapshotPath(), generation,
+                                                    has_source ? &stamp : nullptr, snapshot_error)) {
+            return index;
+        }
+        return parseFile(generation, error);
+    }
+
+    // 读取并解析配置文件，树只在这里遍历一次，之后的查询都走扁平索引
+    static const ConfIndex* parseFile(uint32_t generation, string& error) {
+        // 先取文件状态再读取，读取期间文件被改写时记录的是旧状态，编译出的快照会被判为过期
+        ConfSourceStamp stamp;
+        ConfSourceStamp::of(conf_dir_, stamp);
+        const ifstream file(conf_dir_);
+        if (!file.is_open()) {
+            error = "open " + conf_dir_ + " failed";
+            return nullptr;
+        }
         stringstream buffer;
         buffer << file.rdbuf();
         string content = buffer.str();
-        conf_cjson_ = cJSON_Parse(content.c_str());
-        if (conf_cjson_ == nullptr) {
-            throw runtime_error("加载失败");
+        cJSON* root = cJSON_Parse(content.c_str());
+        if (root == nullptr) {
+            error = "parse " + conf_dir_ + " failed";
+            return nullptr;
         }
+        const auto* index = new ConfIndex(root, generation, stamp);
+        cJSON_Delete(root);
+        return index;
     }
 
-    // 释放内存
-    void freeMemory() {
-        if (conf_cjson_ != nullptr) {
-            cJSON_Delete(conf_cjson_);
-            conf_cjson_ = nullptr;
-        }
-    }
+    // 缺失或类型不符时返回各类型的零值
+    template <typename T>
+    static T valueOf(const ConfEntry* entry);
 
 public:
 
@@ -65,11 +541,148 @@ public:
     ConfLoad(ConfLoad &other) = delete;
     void operator=(const ConfLoad &) = delete;
 
+    // key 为点分路径，大小写不敏感；支持 string、string_view、int、bool、double
+    // 读取不加锁，总是看到某一个完整的快照
+    // string_view 结果指向当前快照，下一次重新加载后失效，只适合立即使用
+    template <typename T>
+    T get_value(std::string_view key) const {
+        ConfEpoch::ReadGuard guard(epoch_);
+        return valueOf<T>(index_.load()->find(key));
+    }
+
     template <typename T>
-    T get_value(string key) {
-        // 需要特化实现
-        static_assert(sizeof(T) == 0, "Unsupported type");
-        return T();
+    T get_value(const ConfKey<T>& key) const {
+        return key.get();
+    }
+
+    [[nodiscard]] bool has(std::string_view key) const {
+        ConfEpoch::ReadGuard guard(epoch_);
+        return index_.load()->find(key) != nullptr;
+    }
+
+    // 在读保护内访问当前快照，visit 返回后快照可能被释放，不要保留其中的指针
+    template <typename Visitor>
+    void read(Visitor&& visit) const {
+        ConfEpoch::ReadGuard guard(epoch_);
+        visit(*index_.load());
+    }
+
+    // 重新解析配置文件，校验通过后原子替换快照，再通知订阅了变化键的监听者
+    // 解析或校验失败时保留旧配置
+    bool reload() {
+        std::lock_guard<std::mutex> reload_lock(reload_mutex_);
+        const ConfIndex* current = index_.load();
+        string error;
+        std::unique_ptr<const ConfIndex> next(loadFile(current->generation() + 1, error));
+        if (next && !validate(*next, error)) {
+            next.reset();
+        }
+        if (!next) {
+            notifyReload(false, error);
+            return false;
+        }
+
+        const std::vector<string> changed = diff(*current, *next);
+        index_.store(next.release());
+        // 等读者离开旧快照后释放
+        epoch_.synchronize();
+        delete current;
+
+        notifyReload(true, std::to_string(changed.size()) + " keys changed");
+        if (!changed.empty()) {
+            notifyListeners(changed);
+        }
+        return true;
+    }
+
+    // 编译快照：重新解析 JSON，通过已注册的校验后把索引映像写入 out（默认 snapshotPath()）
+    // 先写临时文件再 rename，正在映射旧快照的进程不受影响
+    // 快照记录 JSON 文件的大小与修改时间，JSON 之后再被修改时快照自动失效，回退到解析 JSON
+    bool compile(string& error, const string& out = snapshotPath()) {
+        std::unique_ptr<const ConfIndex> index(parseFile(0, error));
+        if (!index || !validate(*index, error)) {
+            return false;
+        }
+        const string tmp = out + ".tmp";
+        const int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            error = "open " + tmp + " failed";
+            return false;
+        }
+        const std::string_view image = index->image();
+        size_t written = 0;
+        while (written < image.size()) {
+            const ssize_t n = ::write(fd, image.data() + written, image.size() - written);
+            if (n <= 0) {
+                break;
+            }
+            written += static_cast<size_t>(n);
+        }
+        const bool ok = written == image.size() && fsync(fd) == 0;
+        close(fd);
+        if (!ok || std::rename(tmp.c_str(), out.c_str()) != 0) {
+            unlink(tmp.c_str());
+            error = "write " + out + " failed";
+            return false;
+        }
+        return true;
+    }
+
+    // 当前配置是否来自映射的快照
+    [[nodiscard]] bool fromSnapshot() const {
+        ConfEpoch::ReadGuard guard(epoch_);
+        return index_.load()->mapped();
+    }
+
+    // 快照文件路径：配置文件路径加 .bin
+    static string snapshotPath() {
+        return conf_dir_ + ".bin";
+    }
+
+    // key 为完整路径或路径前缀（如 "logger" 匹配 logger 下的所有键），返回用于取消的 id
+    // 监听者在重新加载的线程中调用，此时新快照已生效
+    size_t subscribe(std::string_view key, ConfListener listener) {
+        std::lock_guard<std::mutex> lock(listeners_mutex_);
+        const size_t id = ++next_listener_id_;
+        listeners_.push_back(Listener{id, string(key), std::move(listener)});
+        return id;
+    }
+
+    void unsubscribe(size_t id) {
+        std::lock_guard<std::mutex> lock(listeners_mutex_);
+        listeners_.erase(std::remove_if(listeners_.begin(), listeners_.end(),
+            [id](const Listener& listener) { return listener.id == id; }), listeners_.end());
+    }
+
+    void addValidator(ConfValidator validator) {
+        std::lock_guard<std::mutex> lock(listeners_mutex_);
+        validators_.push_back(std::move(validator));
+    }
+
+    void setReloadCallback(ConfReloadCallback callback) {
+        std::lock_guard<std::mutex> lock(listeners_mutex_);
+        reload_callback_ = std::move(callback);
+    }
+
+    // 后台监视配置文件，变化后等待 debounce 再重新加载，合并编辑器的多次写入
+    // Linux 上用 inotify 监视所在目录（覆盖 rename 替换文件的写法），其它平台按修改时间轮询
+    void watch(std::chrono::milliseconds debounce = std::chrono::milliseconds(100)) {
+        std::lock_guard<std::mutex> lock(watch_mutex_);
+        if (watch_thread_.joinable()) {
+            return;
+        }
+        watch_stop_ = false;
+        watch_thread_ = std::thread([this, debounce]() {
+            this->watchLoop(debounce);
+        });
+    }
+
+    void stopWatch() {
+        std::lock_guard<std::mutex> lock(watch_mutex_);
+        watch_stop_ = true;
+        if (watch_thread_.joinable()) {
+            watch_thread_.join();
+        }
     }
 
     static ConfLoad *GetInstance() {
@@ -80,40 +693,241 @@ public:
     }
 
     ~ConfLoad() {
-        freeMemory();
+        stopWatch();
+        delete index_.load();
+    }
+
+    template <typename T>
+    friend class ConfKey;
+
+private:
+    struct Listener {
+        size_t id;
+        string key;
+        ConfListener callback;
+    };
+
+    bool validate(const ConfIndex& next, string& error) {
+        std::lock_guard<std::mutex> lock(listeners_mutex_);
+        for (const auto& validator : validators_) {
+            if (!validator(next, error)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool sameValue(const ConfEntry& a, const ConfEntry& b) {
+        if (a.type != b.type) {
+            return false;
+        }
+        switch (a.type) {
+            case ConfType::BOOL: return a.boolean == b.boolean;
+            case ConfType::NUMBER: return a.number == b.number;
+            case ConfType::STRING: return a.text() == b.text();
+            default: return true;
+        }
+    }
+
+    static std::vector<string> diff(const ConfIndex& before, const ConfIndex& after) {
+        std::vector<string> changed;
+        for (const auto& entry : after) {
+            const ConfEntry* old = before.find(entry.path(), entry.hash);
+            if (!old || !sameValue(*old, entry)) {
+                changed.emplace_back(entry.path());
+            }
+        }
+        for (const auto& entry : before) {
+            if (!after.find(entry.path(), entry.hash)) {
+                changed.emplace_back(entry.path());
+            }
+        }
+        return changed;
+    }
+
+    static bool matches(std::string_view key, std::string_view path) {
+        if (key.size() > path.size() || !confKeyEqual(key, path.substr(0, key.size()))) {
+            return false;
+        }
+        return key.size() == path.size() || path[key.size()] == '.';
     }
+
+    void notifyReload(bool ok, const string& message) {
+        ConfReloadCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(listeners_mutex_);
+            callback = reload_callback_;
+        }
+        if (callback) {
+            callback(ok, message);
+        }
+    }
+
+    // 回调在锁外调用，允许监听者中再读取配置或订阅
+    void notifyListeners(const std::vector<string>& changed) {
+        std::vector<std::pair<ConfListener, std::vector<string>>> calls;
+        {
+            std::lock_guard<std::mutex> lock(listeners_mutex_);
+            for (const auto& listener : listeners_) {
+                std::vector<string> keys;
+                for (const auto& path : changed) {
+                    if (matches(listener.key, path)) {
+                        keys.push_back(path);
+                    }
+                }
+                if (!keys.empty()) {
+                    calls.emplace_back(listener.callback, std::move(keys));
+                }
+            }
+        }
+        for (const auto& [callback, keys] : calls) {
+            callback(keys);
+        }
+    }
+
+    void watchLoop(std::chrono::milliseconds debounce) {
+        using Clock = std::chrono::steady_clock;
+        const size_t slash = conf_dir_.find_last_of('/');
+        const string dir = slash == string::npos ? "." : conf_dir_.substr(0, std::max<size_t>(slash, 1));
+        const string name = slash == string::npos ? conf_dir_ : conf_dir_.substr(slash + 1);
+        bool pending = false;
+        Clock::time_point due;
+#ifdef __linux__
+        const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd >= 0 && inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) >= 0) {
+            alignas(struct inotify_event) char events[4096];
+            while (!watch_stop_) {
+                pollfd pfd{fd, POLLIN, 0};
+                const int timeout = pending ? 10 : 200;
+                if (poll(&pfd, 1, timeout) > 0) {
+                    ssize_t len;
+                    while ((len = ::read(fd, events, sizeof(events))) > 0) {
+                        for (char* p = events; p < events + len;) {
+                            const auto* event = reinterpret_cast<const struct inotify_event*>(p);
+                            if (event->len > 0 && name == event->name) {
+                                pending = true;
+                                due = Clock::now() + debounce;
+                            }
+                            p += sizeof(struct inotify_event) + event->len;
+                        }
+                    }
+                }
+                if (pending && Clock::now() >= due) {
+                    pending = false;
+                    reload();
+                }
+            }
+            close(fd);
+            return;
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+        // 退化为按修改时间轮询
+        struct stat st{};
+        auto last = stat(conf_dir_.c_str(), &st) == 0 ? st.st_mtime : 0;
+        while (!watch_stop_) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(pending ? 10 : 200));
+            if (stat(conf_dir_.c_str(), &st) == 0 && st.st_mtime != last) {
+                last = st.st_mtime;
+                pending = true;
+                due = Clock::now() + debounce;
+            }
+            if (pending && Clock::now() >= due) {
+                pending = false;
+                reload();
+            }
+        }
+    }
+
+    std::mutex reload_mutex_;
+    std::mutex listeners_mutex_;
+    std::vector<Listener> listeners_;
+    std::vector<ConfValidator> validators_;
+    ConfReloadCallback reload_callback_;
+    size_t next_listener_id_ = 0;
+
+    std::mutex watch_mutex_;
+    std::atomic<bool> watch_stop_{false};
+    std::thread watch_thread_;
 };
 
 // 特化实现 string 类型
 template<>
-inline std::string ConfLoad::get_value(string key) {
-    const cJSON* node = get_node(key);
-    if (!node || !cJSON_IsString(node)) return "";
-    return node->valuestring;
+inline std::string ConfLoad::valueOf(const ConfEntry* entry) {
+    if (!entry || entry->type != ConfType::STRING) return "";
+    return string(entry->text());
+}
+
+// 特化实现 string_view 类型，不分配内存
+template<>
+inline std::string_view ConfLoad::valueOf(const ConfEntry* entry) {
+    if (!entry || entry->type != ConfType::STRING) return {};
+    return entry->text();
 }
 
 // 特化实现 int 类型
 template<>
-inline int ConfLoad::get_value(std::string key) {
-    const cJSON* node = get_node(key);
-    if (!node || !cJSON_IsNumber(node)) return 0;
-    return node->valueint;
+inline int ConfLoad::valueOf(const ConfEntry* entry) {
+    if (!entry || entry->type != ConfType::NUMBER) return 0;
+    return entry->integer;
 }
 
 // 特化实现 bool 类型
 template<>
-inline bool ConfLoad::get_value(std::string key) {
-    const cJSON* node = get_node(key);
-    if (!node || !cJSON_IsBool(node)) return false;
-    return cJSON_IsTrue(node);
+inline bool ConfLoad::valueOf(const ConfEntry* entry) {
+    if (!entry || entry->type != ConfType::BOOL) return false;
+    return entry->boolean;
 }
 
 // 特化实现 double 类型
 template<>
-inline double ConfLoad::get_value(std::string key) {
-    const cJSON* node = get_node(key);
-    if (!node || !cJSON_IsNumber(node)) return 0.0;
-    return node->valuedouble;
+inline double ConfLoad::valueOf(const ConfEntry* entry) {
+    if (!entry || entry->type != ConfType::NUMBER) return 0.0;
+    return entry->number;
 }
 
-#endif //FRAME_CONFLOAD_H
\ No newline at end of file
+// 预先解析的配置键：构造时计算哈希，每个快照只定位一次条目，之后读取 O(1)，不再哈希和比较路径
+// 缓存按快照代数失效，重新加载后第一次读取重新定位
+template <typename T>
+class ConfKey {
+public:
+    explicit ConfKey(std::string_view path)
+        : path_(path)
+        , hash_(confKeyHash(path_)) {}
+
+    [[nodiscard]] T get() const {
+        ConfLoad* conf = ConfLoad::GetInstance();
+        ConfEpoch::ReadGuard guard(conf->epoch_);
+        return ConfLoad::valueOf<T>(resolve(*conf->index_.load()));
+    }
+
+    [[nodiscard]] bool exists() const {
+        ConfLoad* conf = ConfLoad::GetInstance();
+        ConfEpoch::ReadGuard guard(conf->epoch_);
+        return resolve(*conf->index_.load()) != nullptr;
+    }
+
+    [[nodiscard]] const string& path() const { return path_; }
+
+private:
+    // 缓存为 代数 << 32 | (条目下标 + 1)，下标部分为 0 表示该快照中不存在
+    const ConfEntry* resolve(const ConfIndex& index) const {
+        const uint64_t cached = cache_.load(std::memory_order_relaxed);
+        if (cached != 0 && static_cast<uint32_t>(cached >> 32) == index.generation()) {
+            const auto slot = static_cast<uint32_t>(cached);
+            return slot == 0 ? nullptr : index.begin() + (slot - 1);
+        }
+        const ConfEntry* entry = index.find(path_, hash_);
+        const uint64_t slot = entry ? static_cast<uint64_t>(entry - index.begin()) + 1 : 0;
+        cache_.store(static_cast<uint64_t>(index.generation()) << 32 | slot, std::memory_order_relaxed);
+        return entry;
+    }
+
+    string path_;
+    uint64_t hash_;
+    mutable std::atomic<uint64_t> cache_{0};
+};
+
+#endif //FRAME_CONFLOAD_H
@@ -0,0 +1,158 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_CPUTOPOLOGY_H
+#define FRAME_CPUTOPOLOGY_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "Tool.h"
+
+using namespace std;
+
+// NUMA 节点及其在线 CPU
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;
+};
+
+// CPU / NUMA 拓扑，从 sysfs 读取
+// 非 Linux 或 sysfs 不可用时退化为单节点，包含 0..N-1 号 CPU
+class CpuTopology {
+public:
+    static CpuTopology detect() {
+        CpuTopology topo;
+        const string node_root = "/sys/devices/system/node";
+        if (DIR* dir = opendir(node_root.c_str())) {
+            while (const dirent* entry = readdir(dir)) {
+                const string name = entry->d_name;
+                if (name.size() <= 4 || name.compare(0, 4, "node") != 0
+                    || name.find_first_not_of("0123456789", 4) != string::npos) {
+                    continue;
+                }
+                NumaNode node;
+                node.id = std::atoi(name.c_str() + 4);
+                node.cpus = readCpuList(node_root + "/" + name + "/cpulist");
+                if (!node.cpus.empty()) {
+                    topo.nodes_.push_back(std::move(node));
+                }
+            }
+            closedir(dir);
+        }
+        if (topo.nodes_.empty()) {
+            NumaNode node;
+            node.id = 0;
+            node.cpus = readCpuList("/sys/devices/system/cpu/online");
+            if (node.cpus.empty()) {
+                const long n = sysconf(_SC_NPROCESSORS_ONLN);
+                for (long cpu = 0; cpu < std::max(n, 1L); ++cpu) {
+                    node.cpus.push_back(static_cast<int>(cpu));
+                }
+            }
+            topo.nodes_.push_back(std::move(node));
+        }
+        std::sort(topo.nodes_.begin(), topo.nodes_.end(),
+                  [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+        for (size_t i = 0; i < topo.nodes_.size(); ++i) {
+            for (const int cpu : topo.nodes_[i].cpus) {
+                if (static_cast<size_t>(cpu) >= topo.cpu_to_node_.size()) {
+                    topo.cpu_to_node_.resize(cpu + 1, -1);
+                }
+                topo.cpu_to_node_[cpu] = static_cast<int>(i);
+            }
+        }
+        return topo;
+    }
+
+    [[nodiscard]] size_t nodeCount() const { return nodes_.size(); }
+    [[nodiscard]] const std::vector<NumaNode>& nodes() const { return nodes_; }
+
+    [[nodiscard]] size_t cpuCount() const {
+        size_t count = 0;
+        for (const auto& node : nodes_) {
+            count += node.cpus.size();
+        }
+        return count;
+    }
+
+    // CPU 所在节点在 nodes() 中的下标，未知 CPU 返回 -1
+    [[nodiscard]] int nodeOfCpu(int cpu) const {
+        if (cpu < 0 || static_cast<size_t>(cpu) >= cpu_to_node_.size()) {
+            return -1;
+        }
+        return cpu_to_node_[cpu];
+    }
+
+    // 调用线程当前运行的 CPU，不支持时返回 -1
+    static int currentCpu() {
+#ifdef __linux__
+        return sched_getcpu();
+#else
+        return -1;
+#endif
+    }
+
+    // 把调用线程绑定到给定 CPU 集合，不支持时返回 false
+    static bool pinCurrentThread(const std::vector<int>& cpus) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (const int cpu : cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpus;
+        return false;
+#endif
+    }
+
+    // 解析 "0-3,8,10-11" 格式的 CPU 列表
+    static std::vector<int> parseCpuList(string list) {
+        std::vector<int> cpus;
+        list.erase(std::remove_if(list.begin(), list.end(),
+                                  [](char c) { return c == '\n' || c == ' '; }), list.end());
+        if (list.empty()) {
+            return cpus;
+        }
+        vector<string> ranges;
+        spilt_string(list, ",", ranges);
+        for (const auto& range : ranges) {
+            if (range.empty()) {
+                continue;
+            }
+            const size_t dash = range.find('-');
+            const int first = std::atoi(range.c_str());
+            const int last = dash == string::npos ? first : std::atoi(range.c_str() + dash + 1);
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+private:
+    static std::vector<int> readCpuList(const string& path) {
+        std::ifstream in(path);
+        string line;
+        if (!in || !std::getline(in, line)) {
+            return {};
+        }
+        return parseCpuList(line);
+    }
+
+    std::vector<NumaNode> nodes_;
+    std::vector<int> cpu_to_node_;
+};
+
+#endif //FRAME_CPUTOPOLOGY_H
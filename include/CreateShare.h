@@ -5,18 +5,97 @@
 #ifndef FRAME_CREATESHARE_H
 #define FRAME_CREATESHARE_H
 
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <new>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <Logger.h>
+#include <SeqLock.h>
 #include <Tool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <csignal>
+#include <sys/file.h>
 #include <sys/mman.h>
 #include <sys/shm.h>
+#include <sys/stat.h>
 
 using namespace std;
-// 程序控制的共享内存
+
+// 控制面配置文本，整体按顺序锁读写，读者不会看到写了一半的内容
+struct CtrlConfig {
+    char text[1024];
+};
+
+// 控制命令
+enum class CtrlOp : uint32_t {
+    NONE = 0,
+    PING = 1,       // 查询状态
+    STOP = 2,       // 停止接收任务，排空后退出
+    SET = 3         // 运行中调整参数
+};
+
+struct CtrlCommand {
+    CtrlOp op;
+    char key[64];
+    char value[188];
+};
+
+struct CtrlReply {
+    int32_t status;         // 0 为成功
+    char message[1020];
+};
+
+// 预派生模式下一个工作进程的状态：pid、state 的 STARTING 与 restarts 由主进程写，其余由工作进程写
+struct alignas(64) CtrlWorker {
+    enum : uint32_t { EMPTY = 0, STARTING = 1, RUNNING = 2, STOPPING = 3, EXITED = 4 };
+
+    std::atomic<uint32_t> pid{0};
+    std::atomic<uint32_t> state{EMPTY};
+    std::atomic<int64_t> heartbeatNs{0};    // steady_clock，同一主机上各进程可比
+    std::atomic<uint64_t> completed{0};     // 已完成的任务数，跨重启累计
+    std::atomic<uint64_t> dropped{0};       // 在本地队列中到期或被拒绝的任务数，跨重启累计
+    std::atomic<uint32_t> active{0};        // 正在执行任务的线程数
+    std::atomic<uint32_t> queued{0};        // 已取出、尚未执行完的任务数
+    std::atomic<uint32_t> restarts{0};
+};
+
+// 程序控制的共享内存，全零即为初始状态（System V 段不会调用构造函数）
+// 命令邮箱：客户端先以 owner 取得邮箱，写好 command 后把 request 加一并唤醒服务端；
+// 服务端处理后写 reply，把 replied 置为同一序号并唤醒客户端。request 与 replied 是跨进程的 futex 字
 struct CtrlShared {
-    bool running;
-    char config[1024];
-    CtrlShared():running(false), config("") {}
+    std::atomic<bool> running;
+    SeqLock<CtrlConfig> config;
+    std::atomic<uint32_t> serverPid{0};
+    std::atomic<uint32_t> owner{0};         // 持有邮箱的客户端 pid，0 为空闲
+    std::atomic<uint32_t> request{0};
+    std::atomic<uint32_t> replied{0};
+    CtrlCommand command{};
+    CtrlReply reply{};
+    // 预派生模式：主进程把 workerStop 置 1 通知各工作进程排空退出
+    static constexpr size_t kMaxWorkers = 64;
+    std::atomic<uint32_t> workerCount{0};
+    std::atomic<uint32_t> workerStop{0};
+    std::atomic<int32_t> workerLogLevel{-1};    // 主进程经 -set 调整的日志级别，工作进程在心跳时应用，-1 为未调整
+    CtrlWorker workers[kMaxWorkers];
+
+    CtrlShared() : running(false) {}
+
+    void setConfig(std::string_view text) {
+        CtrlConfig value{};
+        std::memcpy(value.text, text.data(), std::min(text.size(), sizeof(value.text) - 1));
+        config.store(value);
+    }
+
+    [[nodiscard]] string getConfig() const {
+        const CtrlConfig value = config.load();
+        return string(value.text, strnlen(value.text, sizeof(value.text)));
+    }
 };
 
 /* 权限位
@@ -30,56 +109,401 @@ enum SharedAuthority {
     OWN_RW_OTH_N = 0600,
 };
 
+// 共享内存后端
+enum class ShareBackend {
+    SYSV,       // ftok + shmget + shmat，键可能冲突，大小固定为 sizeof(T)
+    POSIX       // shm_open + mmap，按路径与编号命名，带版本头，可映射任意大小，可用大页
+};
+
+struct ShareOptions {
+    ShareBackend backend;
+    bool hugePages;             // 仅 POSIX：在 hugetlbfs 上建段并以 MAP_HUGETLB 映射，不可用时退回普通页
+    size_t size;                // 数据区字节数，0 表示 sizeof(T)；多出的部分从 get() 之后开始，见 capacity()
+    string hugePageDir;         // hugetlbfs 挂载点
+    std::chrono::milliseconds attachTimeout;   // 等待创建者完成初始化的时长
+    bool readOnly;              // 只附加已存在的段并以只读方式映射，不创建；用于旁路观察，get() 所指对象不可写
+
+    ShareOptions() :
+        backend(ShareBackend::SYSV),
+        hugePages(false),
+        size(0),
+        hugePageDir("/dev/hugepages"),
+        attachTimeout(1000),
+        readOnly(false) {}
+};
+
+// POSIX 段的头部，位于映射起始处，数据区从 dataOffset 开始
+// 创建者构造 T 后把 state 置为 READY，附加者等到 READY 并核对版本与大小后才使用
+struct ShareHeader {
+    static constexpr uint64_t kMagic = 0x314d48534b4a46ull;  // "FJKSHM1"
+    static constexpr uint32_t kVersion = 1;
+    enum : uint32_t { EMPTY = 0, INITIALIZING = 1, READY = 2 };
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t dataOffset;
+    uint64_t dataSize;          // 数据区字节数，不小于 sizeof(T)
+    uint64_t typeSize;          // sizeof(T)
+    uint64_t mappedSize;        // 整个映射字节数，大页模式下按页大小取整
+    std::atomic<uint32_t> state;
+    uint32_t creatorPid;
+};
+
 template<typename T>
 class CreateShare {
 public:
     explicit CreateShare(
             int share_data_id,
             const SharedAuthority share_data_mode = OWN_RW_OTH_RW,
-            string share_path = "/tmp"):
+            string share_path = "/tmp",
+            const ShareOptions& options = ShareOptions()):
         share_path_(std::move(share_path)),
         share_data_id_(share_data_id),
         share_data_mode_(share_data_mode),
-        data_(new T){
-        if (ensureFileExists(share_path_)) {
+        options_(options),
+        key_(-1),
+        shmid_(-1),
+        data_(nullptr),
+        capacity_(std::max(options.size, sizeof(T))) {
+        if (options_.backend == ShareBackend::POSIX) {
+            attachPosix();
+        } else {
+            attachSysV();
+        }
+        if (data_ == nullptr) {
+            // 与原行为一致，附加失败时退化为进程内的私有对象，valid() 为 false
+            local_ = std::make_unique<T>();
+            data_ = local_.get();
+            capacity_ = sizeof(T);
+        }
+    }
+
+    ~CreateShare() {
+        if (local_) {
+            return;
+        }
+        if (mapping_) {
+            munmap(mapping_, mapped_size_);
+        } else {
+            shmdt(data_);
+        }
+    }
+
+    CreateShare(const CreateShare &) = delete;
+    void operator=(const CreateShare &) = delete;
+
+    T* get() { return data_; }
+
+    // SYSV 删除段；POSIX 删除名字，已映射的进程不受影响，最后一个解除映射后释放
+    void remove() const {
+        if (options_.backend == ShareBackend::POSIX) {
+            unlinkSegment(huge_pages_ ? hugePagePath() : name_, huge_pages_);
+        } else {
+            shmctl(shmid_, IPC_RMID, nullptr);
+        }
+    }
+
+    // SYSV 段的 shmid 与 ftok 键，POSIX 后端为 -1
+    [[nodiscard]] int getId() const { return shmid_; }
+    [[nodiscard]] key_t getKey() const { return key_; }
+
+    // 是否真正附加到了共享内存
+    [[nodiscard]] bool valid() const { return !local_; }
+    // 本进程是否创建并初始化了该段
+    [[nodiscard]] bool created() const { return created_; }
+    // 数据区字节数，从 get() 开始
+    [[nodiscard]] size_t capacity() const { return capacity_; }
+    // POSIX 段名，同一路径与编号在所有进程中相同
+    [[nodiscard]] const string& name() const { return name_; }
+    // 是否映射在大页上；请求了大页但不可用时为 false
+    [[nodiscard]] bool hugePages() const { return huge_pages_; }
+
+private:
+    void attachSysV() {
+        if (!ensureFileExists(share_path_)) {
             LOG(ERROR) << "Failed to create file [" << share_path_ << "]: " << strerror(errno);
             return;
         }
         // 1. 生成唯一key
-        key_ = ftok(share_path_.c_str(), static_cast<long long>(share_data_id_));
+        key_ = ftok(share_path_.c_str(), static_cast<int>(share_data_id_));
         if (key_ == -1) {
             LOG(ERROR) << "ftok ["<< share_path_ << ":" << share_data_id_ << "] failed"<< strerror(errno);
             return;
         }
-        shmid_ = shmget(key_, sizeof(T), IPC_CREAT | share_data_mode_);
+        shmid_ = shmget(key_, capacity_, options_.readOnly ? 0 : IPC_CREAT | share_data_mode_);
         if (shmid_ == -1) {
             LOG(ERROR) << "shmget ["<< share_path_ << ":" << share_data_id_ << "] failed"<< strerror(errno);
+            return;
         }
         // 附加到进程空间
-        data_ = static_cast<T *>(shmat(shmid_, nullptr, 0));
-        if (data_ ==  (T*)-1) {
+        void* data = shmat(shmid_, nullptr, options_.readOnly ? SHM_RDONLY : 0);
+        if (data == reinterpret_cast<void*>(-1)) {
             LOG(ERROR) << "shmat ["<< share_path_ << ":" << share_data_id_ << "] failed"<< strerror(errno);
+            return;
         }
+        data_ = static_cast<T*>(data);
     }
 
-    ~CreateShare() {
-        if (data_ != (T*)-1) {
-            shmdt(data_);
+    // 段名由路径与编号直接拼成，不同路径不会像 ftok 那样冲突；过长时取哈希
+    static string posixName(const string& path, size_t id) {
+        string name = "/framejk";
+        for (const char c : path) {
+            name += c == '/' ? '_' : c;
+        }
+        name += "." + std::to_string(id);
+        if (name.size() > 200) {
+            uint64_t hash = 14695981039346656037ull;
+            for (const char c : name) {
+                hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+            }
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "/framejk.%016llx", static_cast<unsigned long long>(hash));
+            name = buf;
         }
+        return name;
     }
 
-    T* get() { return data_; }
-    void remove() const { shmctl(shmid_, IPC_RMID, nullptr); }
-    [[nodiscard]] int getId() const { return shmid_; }
-    [[nodiscard]] key_t getKey() const { return key_; }
+    [[nodiscard]] string hugePagePath() const {
+        return options_.hugePageDir + name_;
+    }
+
+    static size_t hugePageSize() {
+        std::ifstream meminfo("/proc/meminfo");
+        string key;
+        size_t value;
+        string unit;
+        while (meminfo >> key >> value) {
+            std::getline(meminfo, unit);
+            if (key == "Hugepagesize:") {
+                return value * 1024;
+            }
+        }
+        return 2 * 1024 * 1024;
+    }
+
+    void attachPosix() {
+        name_ = posixName(share_path_, share_data_id_);
+        if (options_.hugePages) {
+            if (mapSegment(true)) {
+                return;
+            }
+        }
+        // 退回普通页时不写日志，调用方可能处在还不能写日志的阶段（预派生的 zygote fork 之前），由调用方比较 hugePages()
+        mapSegment(false);
+    }
+
+    // reclaim 为 true 时，创建者中途退出留下的段删除后重试一次
+    bool mapSegment(bool huge, bool reclaim = true) {
+        const size_t data_offset = (sizeof(ShareHeader) + kDataAlign - 1) / kDataAlign * kDataAlign;
+        const string path = huge ? hugePagePath() : name_;
+        bool created = false;
+        const int fd = openSegment(path, huge, created);
+        if (fd < 0) {
+            if (!huge) {
+                LOG(ERROR) << "shm_open [" << name_ << "] failed: " << strerror(errno);
+            }
+            return false;
+        }
+
+        size_t mapped = data_offset + capacity_;
+        if (created) {
+            if (huge) {
+                const size_t page = hugePageSize();
+                mapped = (mapped + page - 1) / page * page;
+            }
+            if (ftruncate(fd, static_cast<off_t>(mapped)) != 0) {
+                LOG(ERROR) << "ftruncate [" << path << "] failed: " << strerror(errno);
+                close(fd);
+                unlinkSegment(path, huge);
+                return false;
+            }
+        } else {
+            // 附加者按段的实际大小映射，创建者可能申请了更大的数据区
+            mapped = waitForSize(fd, data_offset + sizeof(T));
+            if (mapped < data_offset + sizeof(T)) {
+                LOG(ERROR) << "Shared segment [" << name_ << "] is " << mapped << " bytes, smaller than "
+                           << data_offset + sizeof(T);
+                // 长度为 0 说明创建者在 ftruncate 之前就退出了，连 pid 都没有写下
+                const bool retry = mapped == 0 && reclaim && reclaimAbandoned(fd, path, huge, 0);
+                close(fd);
+                return retry && mapSegment(huge, false);
+            }
+        }
+
+        int map_flags = MAP_SHARED;
+#ifdef MAP_HUGETLB
+        if (huge) {
+            map_flags |= MAP_HUGETLB;
+        }
+#endif
+        const int prot = options_.readOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+        void* mapping = mmap(nullptr, mapped, prot, map_flags, fd, 0);
+        if (mapping == MAP_FAILED && map_flags != MAP_SHARED) {
+            // hugetlbfs 文件本身就是大页，个别内核不接受额外的 MAP_HUGETLB
+            mapping = mmap(nullptr, mapped, prot, MAP_SHARED, fd, 0);
+        }
+        if (mapping == MAP_FAILED) {
+            // 大页未预留时在这里失败
+            LOG(ERROR) << "mmap [" << path << "] failed: " << strerror(errno);
+            close(fd);
+            if (created) {
+                unlinkSegment(path, huge);
+            }
+            return false;
+        }
+        auto* header = static_cast<ShareHeader*>(mapping);
+        auto* data = static_cast<char*>(mapping) + data_offset;
+
+        if (created) {
+            // pid 最先写入，附加者超时后据此判断创建者是否还在
+            header->creatorPid = static_cast<uint32_t>(getpid());
+            header->state.store(ShareHeader::INITIALIZING, std::memory_order_relaxed);
+            header->magic = ShareHeader::kMagic;
+            header->version = ShareHeader::kVersion;
+            header->dataOffset = static_cast<uint32_t>(data_offset);
+            header->dataSize = capacity_;
+            header->typeSize = sizeof(T);
+            header->mappedSize = mapped;
+            new (data) T();
+            header->state.store(ShareHeader::READY, std::memory_order_release);
+            created_ = true;
+        } else {
+            const bool ready = waitReady(*header);
+            if (!ready || !checkLayout(*header, data_offset, mapped)) {
+                const uint32_t creator = header->creatorPid;
+                munmap(mapping, mapped);
+                const bool retry = !ready && reclaim && reclaimAbandoned(fd, path, huge, creator);
+                close(fd);
+                return retry && mapSegment(huge, false);
+            }
+            capacity_ = header->dataSize;
+        }
+        close(fd);
+        mapping_ = mapping;
+        mapped_size_ = mapped;
+        huge_pages_ = huge;
+        data_ = reinterpret_cast<T*>(data);
+        return true;
+    }
+
+    static void unlinkSegment(const string& path, bool huge) {
+        if (huge) {
+            unlink(path.c_str());
+        } else {
+            shm_unlink(path.c_str());
+        }
+    }
+
+    // 先尝试独占创建，已存在时以读写方式打开；只读模式只打开已存在的段
+    int openSegment(const string& path, bool huge, bool& created) const {
+        if (options_.readOnly) {
+            created = false;
+            return huge ? open(path.c_str(), O_RDONLY | O_CLOEXEC) : shm_open(path.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        }
+        const int flags = O_RDWR | O_CLOEXEC;
+        int fd = huge ? open(path.c_str(), flags | O_CREAT | O_EXCL, share_data_mode_)
+                      : shm_open(path.c_str(), flags | O_CREAT | O_EXCL, share_data_mode_);
+        if (fd >= 0) {
+            // 不受 umask 影响
+            fchmod(fd, share_data_mode_);
+            created = true;
+            return fd;
+        }
+        if (errno != EEXIST) {
+            return -1;
+        }
+        created = false;
+        return huge ? open(path.c_str(), flags) : shm_open(path.c_str(), flags, 0);
+    }
+
+    // 创建者 ftruncate 之前文件长度为 0，附加者等待；返回段大小，超时时小于 needed，出错返回 0
+    size_t waitForSize(int fd, size_t needed) const {
+        const auto deadline = std::chrono::steady_clock::now() + options_.attachTimeout;
+        struct stat st{};
+        while (fstat(fd, &st) == 0) {
+            if (static_cast<size_t>(st.st_size) >= needed || std::chrono::steady_clock::now() >= deadline) {
+                return static_cast<size_t>(st.st_size);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return 0;
+    }
+
+    // 创建者在独占创建之后、置 READY 之前退出时，段永远停在未初始化状态，之后的附加者都会超时
+    // 超时后创建者已不在（pid 未写下也按不在处理）时删除名字，返回 true 由调用方重新创建；只读附加者不处理
+    // 删除前持段上的文件锁并确认名字仍指向这个段：多个附加者同时发现时只有第一个删除，其余直接重新附加它建的新段
+    bool reclaimAbandoned(int fd, const string& path, bool huge, uint32_t creator) const {
+        if (options_.readOnly) {
+            return false;
+        }
+        if (creator != 0 && (kill(static_cast<pid_t>(creator), 0) == 0 || errno == EPERM)) {
+            return false;
+        }
+        if (flock(fd, LOCK_EX) != 0) {
+            return false;
+        }
+        struct stat ours{};
+        struct stat named{};
+        bool same = false;
+        if (fstat(fd, &ours) == 0) {
+            const int current = huge ? open(path.c_str(), O_RDONLY | O_CLOEXEC) : shm_open(path.c_str(), O_RDONLY | O_CLOEXEC, 0);
+            if (current >= 0) {
+                same = fstat(current, &named) == 0 && named.st_ino == ours.st_ino && named.st_dev == ours.st_dev;
+                close(current);
+            }
+        }
+        if (same) {
+            LOG(WARN) << "Shared segment [" << name_ << "] abandoned by "
+                      << (creator != 0 ? "pid " + std::to_string(creator) : string("its creator"))
+                      << " before initialization, recreating";
+            unlinkSegment(path, huge);
+        }
+        flock(fd, LOCK_UN);
+        return true;
+    }
+
+    bool waitReady(const ShareHeader& header) const {
+        const auto deadline = std::chrono::steady_clock::now() + options_.attachTimeout;
+        while (header.state.load(std::memory_order_acquire) != ShareHeader::READY) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                LOG(ERROR) << "Shared segment [" << name_ << "] not initialized by pid " << header.creatorPid;
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    bool checkLayout(const ShareHeader& header, size_t data_offset, size_t mapped) const {
+        if (header.magic != ShareHeader::kMagic || header.version != ShareHeader::kVersion
+            || header.typeSize != sizeof(T) || header.dataOffset != data_offset
+            || header.dataSize < sizeof(T) || header.mappedSize > mapped
+            || data_offset + header.dataSize > mapped) {
+            LOG(ERROR) << "Shared segment [" << name_ << "] layout mismatch: version " << header.version
+                       << ", type size " << header.typeSize << " (expected " << sizeof(T) << ")";
+            return false;
+        }
+        return true;
+    }
+
+    static constexpr size_t kDataAlign = 64;
 
-private:
     string share_path_;
     size_t share_data_id_;
     SharedAuthority share_data_mode_;
+    ShareOptions options_;
     key_t key_;
     int shmid_;
     T* data_;
+    size_t capacity_;
+    std::unique_ptr<T> local_;
+
+    // POSIX 后端
+    string name_;
+    void* mapping_ = nullptr;
+    size_t mapped_size_ = 0;
+    bool huge_pages_ = false;
+    bool created_ = false;
 };
 
-#endif //FRAME_CREATESHARE_H
\ No newline at end of file
+#endif //FRAME_CREATESHARE_H
@@ -0,0 +1,47 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_FUTEX_H
+#define FRAME_FUTEX_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <thread>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// 跨进程的 futex：不带 FUTEX_PRIVATE_FLAG，按物理页匹配，等待与唤醒可以在不同进程
+// 非 Linux 平台退化为短睡眠
+inline void futexWait(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::milliseconds timeout) {
+#ifdef __linux__
+    struct timespec ts{};
+    ts.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+    ts.tv_nsec = static_cast<long>(timeout.count() % 1000) * 1000000;
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected,
+            timeout.count() > 0 ? &ts : nullptr, nullptr, 0);
+#else
+    if (word.load(std::memory_order_acquire) == expected) {
+        std::this_thread::sleep_for(std::min(timeout, std::chrono::milliseconds(1)));
+    }
+#endif
+}
+
+inline void futexWake(std::atomic<uint32_t>& word, int count) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+#else
+    (void)word;
+    (void)count;
+#endif
+}
+
+#endif //FRAME_FUTEX_H
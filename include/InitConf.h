@@ -6,17 +6,32 @@
 #define FRAME_INITCONF_H
 
 #include <ConfLoad.h>
+#include <CreateShare.h>
 #include <Logger.h>
+#include <ShmStats.h>
+#include <TaskQueue.h>
+#include <ThreadPool.h>
+#include <Prefork.h>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
 #include <string>
 
 using namespace std;
 // 声明
 void InitConf();
 void InitLogger();
+void InitClientLogger();
+void InitHotReload();
+void InitScheduler();
+void InitStats();
+void AttachStats();
 
 
 inline void InitConf() {
     InitLogger();
+    InitScheduler();
+    InitHotReload();
 }
 
 inline void InitLogger() {
@@ -30,7 +45,296 @@ inline void InitLogger() {
     conf_->consoleOutput = conf_load_->get_value<bool>("logger.consoleOutput");
     conf_->maxFiles = conf_load_->get_value<int>("logger.maxFiles");
     conf_->maxFileSize = conf_load_->get_value<int>("logger.maxFileSize") * 1024;
+    conf_->ringMode = conf_load_->get_value<bool>("logger.ringMode");
+    conf_->binaryMode = conf_load_->get_value<bool>("logger.binaryMode");
+    conf_->mmapSink = conf_load_->get_value<bool>("logger.mmapSink");
+    conf_->syncInterval = static_cast<size_t>(std::max(conf_load_->get_value<int>("logger.syncIntervalMs"), 0));
+    conf_->syncOnFatal = conf_load_->get_value<bool>("logger.syncOnFatal");
+    if (const int capacity = conf_load_->get_value<int>("logger.ringCapacity"); capacity > 0) {
+        conf_->ringCapacity = static_cast<size_t>(capacity);
+    }
+    const string policy = conf_load_->get_value<string>("logger.overflowPolicy");
+    if (policy == "dropNewest") {
+        conf_->overflowPolicy = LogOverflowPolicy::DROP_NEWEST;
+    } else if (policy == "dropOldest") {
+        conf_->overflowPolicy = LogOverflowPolicy::DROP_OLDEST;
+    }
     SpdLogger::set_config(conf_);
 }
 
+// 命令行客户端（-stop、-ping、-set、-stats、-compile）的日志：同步写控制台，不写日志文件也不起线程
+// 这些命令与运行中的服务进程共用配置，按服务的配置初始化日志会写进服务进程的日志文件
+inline void InitClientLogger() {
+    auto* conf_ = new LoggerConfig;
+    conf_->minLogLevel = LogLevel::WARN;
+    conf_->asyncMode = false;
+    conf_->fileOutput = false;
+    SpdLogger::set_config(conf_);
+}
+
+// 配置热加载：conf.hotReload 开启时后台监视配置文件
+// 目前日志最低级别随配置生效，其它组件通过 ConfLoad::subscribe 订阅各自的键
+inline void InitHotReload() {
+    ConfLoad* conf_load_ = ConfLoad::GetInstance();
+    conf_load_->addValidator([](const ConfIndex& next, string& error) {
+        const ConfEntry* level = next.find("logger.minLevel");
+        if (level && level->type == ConfType::STRING) {
+            static const char* const names[] = {"DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+            if (std::none_of(std::begin(names), std::end(names),
+                             [&](const char* name) { return level->text() == name; })) {
+                error = "invalid logger.minLevel: " + string(level->text());
+                return false;
+            }
+        }
+        return true;
+    });
+    conf_load_->setReloadCallback([](bool ok, const string& message) {
+        if (ok) {
+            LOG(INFO) << "Config reloaded: " << message;
+        } else {
+            LOG(ERROR) << "Config reload rejected: " << message;
+        }
+    });
+    conf_load_->subscribe("logger.minLevel", [](const vector<string>&) {
+        SpdLogger::GetInstance()->setMinLevel(
+            stringToLogLevel(ConfLoad::GetInstance()->get_value<string>("logger.minLevel")));
+    });
+    if (conf_load_->get_value<bool>("conf.hotReload")) {
+        // 监视线程会写日志，日志单例的延迟创建不是线程安全的，先在本线程建好
+        SpdLogger::GetInstance();
+        const int debounce = conf_load_->get_value<int>("conf.reloadDebounceMs");
+        conf_load_->watch(std::chrono::milliseconds(debounce > 0 ? debounce : 100));
+    }
+}
+
+// 从 scheduler 段读取调度参数，缺省的键保留 SchedulerConfig 的默认值；取值非法时返回 false
+inline bool BindSchedulerConfig(const ConfIndex& index, SchedulerConfig& conf, string& error) {
+    static const char* const lanes[] = {"low", "normal", "high", "critical"};
+    const auto number = [&](const string& key, double& out) {
+        const ConfEntry* entry = index.find("scheduler." + key);
+        if (entry && entry->type == ConfType::NUMBER) {
+            out = entry->number;
+            return true;
+        }
+        return false;
+    };
+    const auto millis = [&](const string& key, std::chrono::milliseconds& out, bool allow_zero) {
+        double value;
+        if (!number(key, value)) {
+            return true;
+        }
+        if (value < 0 || (!allow_zero && value == 0)) {
+            error = "invalid scheduler." + key + ": " + std::to_string(value);
+            return false;
+        }
+        out = std::chrono::milliseconds(static_cast<int64_t>(value));
+        return true;
+    };
+
+    double value;
+    if (number("queueMaxSize", value)) {
+        if (value < 1) {
+            error = "invalid scheduler.queueMaxSize: " + std::to_string(value);
+            return false;
+        }
+        conf.queueMaxSize = static_cast<size_t>(value);
+    }
+    if (number("overflowRatio", value)) {
+        if (value < 1.0) {
+            error = "invalid scheduler.overflowRatio: " + std::to_string(value);
+            return false;
+        }
+        conf.overflowRatio = value;
+    }
+    if (!millis("workerPollMs", conf.workerPoll, false)) {
+        return false;
+    }
+    for (size_t lane = 0; lane < TaskLanes::kLaneCount; ++lane) {
+        const string name = lanes[lane];
+        if (!millis("timeoutMs." + name, conf.timeout[lane], false)) {
+            return false;
+        }
+        // 0 表示该级不晋升
+        if (!millis("promoteAfterMs." + name, conf.aging.promote_after[lane], true)) {
+            return false;
+        }
+        if (number("agingPerSecond." + name, value)) {
+            if (value < 0) {
+                error = "invalid scheduler.agingPerSecond." + name + ": " + std::to_string(value);
+                return false;
+            }
+            conf.agingPerSecond[lane] = value;
+        }
+    }
+    // CRITICAL 已是最高级，不能再晋升
+    conf.aging.promote_after[priorityToLane(Priority::CRITICAL)] = std::chrono::milliseconds(0);
+    return true;
+}
+
+// 调度参数：启动时发布一次，热加载时 scheduler 段通过校验后整体替换
+// 队列与线程池只读取 SchedulerTuning 的快照，不在每个任务上查配置
+inline void InitScheduler() {
+    ConfLoad* conf_load_ = ConfLoad::GetInstance();
+    const auto publish = [conf_load_]() {
+        SchedulerConfig conf;
+        string error;
+        bool ok = false;
+        conf_load_->read([&](const ConfIndex& index) {
+            ok = BindSchedulerConfig(index, conf, error);
+        });
+        if (!ok) {
+            LOG(ERROR) << "Scheduler config ignored: " << error;
+            return;
+        }
+        SchedulerTuning::publish(conf);
+        LOG(INFO) << "Scheduler config: queueMaxSize=" << conf.queueMaxSize
+                  << " overflowRatio=" << conf.overflowRatio
+                  << " workerPollMs=" << conf.workerPoll.count();
+    };
+    conf_load_->addValidator([](const ConfIndex& next, string& error) {
+        SchedulerConfig conf;
+        return BindSchedulerConfig(next, conf, error);
+    });
+    conf_load_->subscribe("scheduler", [publish](const vector<string>&) {
+        publish();
+    });
+    publish();
+}
+
+// 统计段位置：stats.sharePath 下的固定编号，服务进程与 -stats 读者一致
+constexpr int kStatsShareId = 3;
+
+inline string StatsSharePath() {
+    ConfLoad* conf_load_ = ConfLoad::GetInstance();
+    return conf_load_->has("stats.sharePath") ? conf_load_->get_value<string>("stats.sharePath") : "/tmp";
+}
+
+inline ShareOptions StatsShareOptions(bool read_only) {
+    ShareOptions options;
+    options.backend = ShareBackend::POSIX;
+    options.readOnly = read_only;
+    return options;
+}
+
+// 运行时统计：stats.enabled 时创建共享统计段，之后创建的线程池、队列、日志写线程等把计数写入其中
+// 只在服务进程中调用，不放在 InitConf 里，避免 -stats 等命令行模式覆盖正在运行的进程的统计段
+// 同名段来自已退出的进程时删除后重建；属于另一个存活进程时不接管，统计只留在进程内
+inline void InitStats() {
+    ConfLoad* conf_load_ = ConfLoad::GetInstance();
+    if (!conf_load_->get_value<bool>("stats.enabled")) {
+        return;
+    }
+    const string path = StatsSharePath();
+    // 统计段随进程存在到退出，不释放
+    auto* share = new CreateShare<StatsSegment>(kStatsShareId, OWN_RW_OTH_R, path, StatsShareOptions(false));
+    if (share->valid() && !share->created()) {
+        const auto owner = static_cast<pid_t>(share->get()->ownerPid.load(std::memory_order_acquire));
+        if (owner != 0 && owner != getpid() && kill(owner, 0) == 0) {
+            LOG(WARN) << "Stats segment " << share->name() << " is owned by running pid " << owner;
+            delete share;
+            return;
+        }
+        share->remove();
+        delete share;
+        share = new CreateShare<StatsSegment>(kStatsShareId, OWN_RW_OTH_R, path, StatsShareOptions(false));
+    }
+    if (!share->valid()) {
+        LOG(WARN) << "Stats segment unavailable, stats stay in process";
+        return;
+    }
+    share->get()->ownerPid.store(static_cast<uint32_t>(getpid()), std::memory_order_release);
+    ShmStats::install(share->get());
+    LOG(INFO) << "Stats segment " << share->name() << " ready";
+}
+
+// 预派生的工作进程：映射主进程已建立的统计段，计数与主进程写在一起；段不存在时统计只留在进程内
+// 工作进程由先于 InitStats 派生的 zygote fork，继承不到主进程的映射，只能按名字重新打开
+inline void AttachStats() {
+    ConfLoad* conf_load_ = ConfLoad::GetInstance();
+    if (!conf_load_->get_value<bool>("stats.enabled")) {
+        return;
+    }
+    // 与主进程的映射一样随进程存在到退出
+    auto* share = new CreateShare<StatsSegment>(kStatsShareId, OWN_RW_OTH_R, StatsSharePath(), StatsShareOptions(false));
+    if (!share->valid() || share->created()) {
+        if (share->created()) {
+            share->remove();
+        }
+        delete share;
+        LOG(WARN) << "Stats segment unavailable in worker, stats stay in process";
+        return;
+    }
+    ShmStats::install(share->get());
+}
+
+// 控制面：-start 写入 ctrl.pidFile 并在 ctrl.sharePath 下建立命令邮箱，-stop / -set 据此找到运行中的进程
+inline string CtrlPidPath() {
+    ConfLoad* conf_load_ = ConfLoad::GetInstance();
+    return conf_load_->has("ctrl.pidFile") ? conf_load_->get_value<string>("ctrl.pidFile") : "/tmp/framejk.pid";
+}
+
+inline string CtrlSharePath() {
+    ConfLoad* conf_load_ = ConfLoad::GetInstance();
+    return conf_load_->has("ctrl.sharePath") ? conf_load_->get_value<string>("ctrl.sharePath") : "/tmp";
+}
+
+// -stop 时等待队列排空的时长
+inline std::chrono::milliseconds CtrlDrainTimeout() {
+    ConfLoad* conf_load_ = ConfLoad::GetInstance();
+    const int timeout = conf_load_->has("ctrl.drainTimeoutMs") ? conf_load_->get_value<int>("ctrl.drainTimeoutMs") : 5000;
+    return std::chrono::milliseconds(std::max(timeout, 0));
+}
+
+// 服务进程的线程池：弹性模式，线程数上下限取自 pool 段，运行中可由 -set 调整（上限不超过这里的 maxThreads）
+inline ThreadPoolConfig PoolConfig() {
+    ConfLoad* conf_load_ = ConfLoad::GetInstance();
+    ThreadPoolConfig conf;
+    conf.elastic = true;
+    if (conf_load_->has("pool.maxThreads")) {
+        conf.maxThreads = static_cast<size_t>(std::max(conf_load_->get_value<int>("pool.maxThreads"), 1));
+    }
+    if (conf_load_->has("pool.minThreads")) {
+        conf.minThreads = static_cast<size_t>(std::max(conf_load_->get_value<int>("pool.minThreads"), 1));
+    }
+    conf.minThreads = std::min(conf.minThreads, conf.maxThreads);
+    conf.numThreads = conf.minThreads;
+    return conf;
+}
+
+// 任务通道：生产者经 ShmTaskProducer 写入，线程模式下由本进程消费，预派生模式下由各工作进程消费
+inline int ChannelId() {
+    ConfLoad* conf_load_ = ConfLoad::GetInstance();
+    return conf_load_->has("channel.id") ? conf_load_->get_value<int>("channel.id") : 16;
+}
+
+inline string ChannelSharePath() {
+    ConfLoad* conf_load_ = ConfLoad::GetInstance();
+    return conf_load_->has("channel.sharePath") ? conf_load_->get_value<string>("channel.sharePath") : "/tmp";
+}
+
+inline bool ChannelHugePages() {
+    ConfLoad* conf_load_ = ConfLoad::GetInstance();
+    return conf_load_->has("channel.hugePages") && conf_load_->get_value<bool>("channel.hugePages");
+}
+
+// 预派生模式：prefork.workers 大于 0 时 -start 作为主进程运行，派生工作进程消费任务通道
+inline PreforkConfig LoadPreforkConfig() {
+    ConfLoad* conf_load_ = ConfLoad::GetInstance();
+    PreforkConfig conf;
+    const auto count = [conf_load_](const char* key, size_t fallback) {
+        return conf_load_->has(key) ? static_cast<size_t>(std::max(conf_load_->get_value<int>(key), 0)) : fallback;
+    };
+    conf.workers = count("prefork.workers", 0);
+    conf.threadsPerWorker = std::max<size_t>(count("prefork.threadsPerWorker", conf.threadsPerWorker), 1);
+    conf.prefetch = count("prefork.prefetch", conf.prefetch);
+    conf.heartbeatInterval = std::chrono::milliseconds(
+        std::max<size_t>(count("prefork.heartbeatIntervalMs", conf.heartbeatInterval.count()), 1));
+    conf.heartbeatTimeout = std::chrono::milliseconds(count("prefork.heartbeatTimeoutMs", conf.heartbeatTimeout.count()));
+    conf.channelId = ChannelId();
+    conf.sharePath = ChannelSharePath();
+    conf.hugePages = ChannelHugePages();
+    conf.drainTimeout = CtrlDrainTimeout();
+    return conf;
+}
+
 #endif //FRAME_INITCONF_H
\ No newline at end of file
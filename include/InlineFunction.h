@@ -0,0 +1,303 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_INLINEFUNCTION_H
+#define FRAME_INLINEFUNCTION_H
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+using namespace std;
+
+// 按线程回收的固定大小内存块，用于放不进内联缓冲区的闭包
+// 块头记录分配它的线程（owner），无论在哪个线程释放都回到 owner：本线程释放直接进空闲链表，
+// 其他线程释放压入 owner 的无锁 remote 栈，owner 本地链表取空时一次取走整个栈
+// 提交线程分配、工作线程执行后释放时，块因此回到提交线程，而不是在工作线程堆积、提交线程一直向系统要新块
+// owner 以引用计数管理：线程本身一份，每个借出的块一份；线程退出后最后一个块归还时释放 owner 与它的 remote 栈
+// 本地链表长度有上限，超出部分归还系统
+class TaskBlockPool {
+public:
+    static constexpr size_t kBlockSize = 256;
+    static constexpr size_t kMaxCached = 1024;
+
+    static void* allocate(size_t size) {
+        if (size > kBlockSize) {
+            return ::operator new(size);
+        }
+        Owner* owner = local().owner;
+        Node* node = owner->head != nullptr ? owner->head : owner->adoptRemote();
+        if (node != nullptr) {
+            owner->head = node->next;
+            --owner->count;
+        } else {
+            char* base = static_cast<char*>(::operator new(kHeaderSize + kBlockSize));
+            reinterpret_cast<Header*>(base)->owner = owner;
+            node = reinterpret_cast<Node*>(base + kHeaderSize);
+        }
+        owner->refs.fetch_add(1, std::memory_order_relaxed);
+        return node;
+    }
+
+    static void deallocate(void* ptr, size_t size) {
+        if (size > kBlockSize) {
+            ::operator delete(ptr);
+            return;
+        }
+        Node* node = static_cast<Node*>(ptr);
+        Owner* owner = ownerOf(node);
+        if (owner != local().owner) {
+            owner->pushRemote(node);
+            owner->release();
+            return;
+        }
+        if (owner->count >= kMaxCached) {
+            freeBlock(node);
+        } else {
+            node->next = owner->head;
+            owner->head = node;
+            ++owner->count;
+        }
+        // 线程本身持有一份引用，这里不会减到 0
+        owner->refs.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+private:
+    struct Node {
+        Node* next;
+    };
+
+    struct Owner;
+
+    // 块头放在闭包之前，占一个最大对齐单位，闭包的对齐与 operator new 相同
+    struct Header {
+        Owner* owner;
+    };
+    static constexpr size_t kHeaderSize = alignof(std::max_align_t);
+    static_assert(sizeof(Header) <= kHeaderSize, "TaskBlockPool header too large");
+
+    struct Owner {
+        Node* head = nullptr;                   // 只由 owner 线程访问
+        size_t count = 0;
+        std::atomic<size_t> refs{1};
+        alignas(64) std::atomic<Node*> remote{nullptr};
+
+        // 其他线程归还的块，只压栈，owner 一次取走整个栈，不存在 ABA
+        void pushRemote(Node* node) {
+            Node* top = remote.load(std::memory_order_relaxed);
+            do {
+                node->next = top;
+            } while (!remote.compare_exchange_weak(top, node, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // 取走 remote 栈放入本地链表，超过上限的部分归还系统；返回新的链表头
+        Node* adoptRemote() {
+            Node* node = remote.exchange(nullptr, std::memory_order_acquire);
+            while (node != nullptr) {
+                Node* next = node->next;
+                if (count >= kMaxCached) {
+                    freeBlock(node);
+                } else {
+                    node->next = head;
+                    head = node;
+                    ++count;
+                }
+                node = next;
+            }
+            return head;
+        }
+
+        void release() {
+            if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                freeList(head);
+                freeList(remote.exchange(nullptr, std::memory_order_acquire));
+                delete this;
+            }
+        }
+    };
+
+    // 线程退出时交还本地缓存和线程那一份引用
+    struct LocalOwner {
+        Owner* owner = new Owner;
+
+        ~LocalOwner() {
+            freeList(owner->head);
+            owner->head = nullptr;
+            owner->count = 0;
+            owner->release();
+        }
+    };
+
+    static Owner* ownerOf(Node* node) {
+        return reinterpret_cast<Header*>(reinterpret_cast<char*>(node) - kHeaderSize)->owner;
+    }
+
+    static void freeBlock(Node* node) {
+        ::operator delete(reinterpret_cast<char*>(node) - kHeaderSize);
+    }
+
+    static void freeList(Node* node) {
+        while (node != nullptr) {
+            Node* next = node->next;
+            freeBlock(node);
+            node = next;
+        }
+    }
+
+    static LocalOwner& local() {
+        static thread_local LocalOwner owner;
+        return owner;
+    }
+};
+
+template <typename Signature, size_t InlineSize = 64>
+class InlineFunction;
+
+// 只可移动的函数对象，闭包不超过 InlineSize 且移动不抛异常时直接存放在对象内部，
+// 否则放入 TaskBlockPool 的内存块，避免 std::function 的堆分配
+template <typename R, typename... Args, size_t InlineSize>
+class InlineFunction<R(Args...), InlineSize> {
+public:
+    InlineFunction() noexcept : ops_(nullptr) {}
+
+    template <typename F,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InlineFunction>>>
+    InlineFunction(F&& f) : ops_(nullptr) { // NOLINT 允许隐式转换，与 std::function 一致
+        using Fn = std::decay_t<F>;
+        if constexpr (fitsInline<Fn>()) {
+            ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+            ops_ = &inlineOps<Fn>;
+        } else {
+            void* block = allocateBoxed<Fn>();
+            try {
+                ::new (block) Fn(std::forward<F>(f));
+            } catch (...) {
+                deallocateBoxed<Fn>(block);
+                throw;
+            }
+            *reinterpret_cast<void**>(storage_) = block;
+            ops_ = &boxedOps<Fn>;
+        }
+    }
+
+    InlineFunction(InlineFunction&& other) noexcept : ops_(other.ops_) {
+        if (ops_ != nullptr) {
+            ops_->move(storage_, other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    InlineFunction& operator=(InlineFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            ops_ = other.ops_;
+            if (ops_ != nullptr) {
+                ops_->move(storage_, other.storage_);
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    InlineFunction(const InlineFunction &) = delete;
+    InlineFunction& operator=(const InlineFunction &) = delete;
+
+    ~InlineFunction() {
+        reset();
+    }
+
+    R operator()(Args... args) {
+        return ops_->invoke(storage_, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    void reset() noexcept {
+        if (ops_ != nullptr) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    template <typename Fn>
+    static constexpr bool fitsInline() {
+        return sizeof(Fn) <= InlineSize
+            && alignof(Fn) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+private:
+    struct Ops {
+        R (*invoke)(void*, Args&&...);
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void*) noexcept;
+    };
+
+    template <typename Fn>
+    static R invokeInline(void* storage, Args&&... args) {
+        return (*static_cast<Fn*>(storage))(std::forward<Args>(args)...);
+    }
+
+    template <typename Fn>
+    static void moveInline(void* dst, void* src) noexcept {
+        Fn* from = static_cast<Fn*>(src);
+        ::new (dst) Fn(std::move(*from));
+        from->~Fn();
+    }
+
+    template <typename Fn>
+    static void destroyInline(void* storage) noexcept {
+        static_cast<Fn*>(storage)->~Fn();
+    }
+
+    template <typename Fn>
+    static R invokeBoxed(void* storage, Args&&... args) {
+        return (*static_cast<Fn*>(*static_cast<void**>(storage)))(std::forward<Args>(args)...);
+    }
+
+    static void moveBoxed(void* dst, void* src) noexcept {
+        *static_cast<void**>(dst) = *static_cast<void**>(src);
+    }
+
+    template <typename Fn>
+    static void destroyBoxed(void* storage) noexcept {
+        Fn* fn = static_cast<Fn*>(*static_cast<void**>(storage));
+        fn->~Fn();
+        deallocateBoxed<Fn>(fn);
+    }
+
+    // 池中的块只按 max_align_t 对齐，对齐要求更高的闭包改用带对齐参数的 operator new
+    template <typename Fn>
+    static void* allocateBoxed() {
+        if constexpr (alignof(Fn) > alignof(std::max_align_t)) {
+            return ::operator new(sizeof(Fn), std::align_val_t(alignof(Fn)));
+        } else {
+            return TaskBlockPool::allocate(sizeof(Fn));
+        }
+    }
+
+    template <typename Fn>
+    static void deallocateBoxed(void* block) noexcept {
+        if constexpr (alignof(Fn) > alignof(std::max_align_t)) {
+            ::operator delete(block, std::align_val_t(alignof(Fn)));
+        } else {
+            TaskBlockPool::deallocate(block, sizeof(Fn));
+        }
+    }
+
+    template <typename Fn>
+    static constexpr Ops inlineOps{&invokeInline<Fn>, &moveInline<Fn>, &destroyInline<Fn>};
+
+    template <typename Fn>
+    static constexpr Ops boxedOps{&invokeBoxed<Fn>, &moveBoxed, &destroyBoxed<Fn>};
+
+    static_assert(InlineSize >= sizeof(void*), "InlineSize too small");
+
+    alignas(std::max_align_t) unsigned char storage_[InlineSize];
+    const Ops* ops_;
+};
+
+#endif //FRAME_INLINEFUNCTION_H
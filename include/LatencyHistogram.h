@@ -0,0 +1,251 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_LATENCYHISTOGRAM_H
+#define FRAME_LATENCYHISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "TaskQueue.h"
+
+using namespace std;
+
+// 对数-线性分桶：[0, 16) 每纳秒一个桶，之后每个 2 的幂区间等分为 16 个桶，相对误差不超过 1/16
+// 上限约 68 秒（2^36 ns），更大的值计入最后一个桶
+struct LatencyBuckets {
+    static constexpr unsigned kSubBits = 4;
+    static constexpr uint64_t kSubCount = 1u << kSubBits;
+    static constexpr unsigned kMaxExponent = 36;
+    static constexpr size_t kCount = kSubCount + (kMaxExponent - kSubBits) * kSubCount;
+
+    static size_t index(uint64_t ns) {
+        if (ns < kSubCount) {
+            return static_cast<size_t>(ns);
+        }
+        const unsigned exponent = 63u - static_cast<unsigned>(__builtin_clzll(ns));
+        if (exponent >= kMaxExponent) {
+            return kCount - 1;
+        }
+        const uint64_t sub = (ns >> (exponent - kSubBits)) - kSubCount;
+        return kSubCount + (exponent - kSubBits) * kSubCount + static_cast<size_t>(sub);
+    }
+
+    // 桶内最大值，分位数按此报告，不会低估
+    static uint64_t upperBound(size_t index) {
+        if (index < kSubCount) {
+            return index;
+        }
+        const size_t group = (index - kSubCount) / kSubCount;
+        const uint64_t sub = (index - kSubCount) % kSubCount;
+        const unsigned shift = static_cast<unsigned>(group);
+        return ((kSubCount + sub + 1) << shift) - 1;
+    }
+};
+
+// 合并后的直方图，可查询分位数
+struct LatencySnapshot {
+    std::array<uint64_t, LatencyBuckets::kCount> counts{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    void merge(const LatencySnapshot& other) {
+        for (size_t i = 0; i < counts.size(); ++i) {
+            counts[i] += other.counts[i];
+        }
+        count += other.count;
+        sum += other.sum;
+        max = std::max(max, other.max);
+    }
+
+    // q 取 [0, 1]，返回纳秒；空直方图返回 0
+    [[nodiscard]] uint64_t percentile(double q) const {
+        if (count == 0) {
+            return 0;
+        }
+        const auto rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(LatencyBuckets::upperBound(i), max);
+            }
+        }
+        return max;
+    }
+
+    [[nodiscard]] uint64_t mean() const {
+        return count == 0 ? 0 : sum / count;
+    }
+};
+
+// 单写者直方图：每个工作线程写自己的一份，读者随时以 relaxed 读取合并
+// 单写者下自增用 load + store，不需要带锁前缀的原子指令
+class LatencyHistogram {
+public:
+    void record(uint64_t ns) {
+        bump(counts_[LatencyBuckets::index(ns)], 1);
+        bump(count_, 1);
+        bump(sum_, ns);
+        if (ns > max_.load(std::memory_order_relaxed)) {
+            max_.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    void mergeInto(LatencySnapshot& out) const {
+        // 与写入并发时各字段之间可能相差几次记录，分位数查询越界时返回 max
+        out.count += count_.load(std::memory_order_relaxed);
+        out.sum += sum_.load(std::memory_order_relaxed);
+        out.max = std::max(out.max, max_.load(std::memory_order_relaxed));
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            out.counts[i] += counts_[i].load(std::memory_order_relaxed);
+        }
+    }
+
+private:
+    static void bump(std::atomic<uint64_t>& value, uint64_t delta) {
+        value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, LatencyBuckets::kCount> counts_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// 记录的延迟种类
+enum class LatencyKind {
+    QUEUE_WAIT,     // 提交到出队
+    EXECUTION,      // 执行耗时
+    TOTAL           // 提交到执行结束
+};
+
+// 线程池任务延迟：每个工作线程槽位一组直方图，按优先级和种类区分，查询时合并
+class LatencyMetrics {
+public:
+    static constexpr size_t kPriorities = 4;
+    static constexpr size_t kKinds = 3;
+
+    explicit LatencyMetrics(size_t shards) {
+        for (size_t i = 0; i < shards; ++i) {
+            shards_.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    // 只能由 shard 对应的工作线程调用
+    void record(size_t shard, Priority priority, uint64_t wait_ns, uint64_t exec_ns) {
+        if (shard >= shards_.size()) {
+            return;
+        }
+        auto& histograms = shards_[shard]->histograms[priorityIndex(priority)];
+        histograms[static_cast<size_t>(LatencyKind::QUEUE_WAIT)].record(wait_ns);
+        histograms[static_cast<size_t>(LatencyKind::EXECUTION)].record(exec_ns);
+        histograms[static_cast<size_t>(LatencyKind::TOTAL)].record(wait_ns + exec_ns);
+    }
+
+    [[nodiscard]] LatencySnapshot snapshot(LatencyKind kind, Priority priority) const {
+        LatencySnapshot out;
+        for (const auto& shard : shards_) {
+            shard->histograms[priorityIndex(priority)][static_cast<size_t>(kind)].mergeInto(out);
+        }
+        return out;
+    }
+
+    // 每行一个优先级与种类：count mean p50 p99 p999 max，单位微秒
+    [[nodiscard]] string toText() const {
+        string out;
+        char line[256];
+        forEach([&](Priority priority, LatencyKind kind, const LatencySnapshot& snap) {
+            std::snprintf(line, sizeof(line),
+                "%-8s %-10s count=%" PRIu64 " mean=%.1fus p50=%.1fus p99=%.1fus p999=%.1fus max=%.1fus\n",
+                priorityName(priority), kindName(kind), snap.count,
+                micros(snap.mean()), micros(snap.percentile(0.5)), micros(snap.percentile(0.99)),
+                micros(snap.percentile(0.999)), micros(snap.max));
+            out += line;
+        });
+        return out;
+    }
+
+    // {"CRITICAL":{"queueWait":{"count":..,"mean":..,"p50":..,"p99":..,"p999":..,"max":..},...},...}，单位纳秒
+    [[nodiscard]] string toJson() const {
+        string out = "{";
+        Priority current = Priority::CRITICAL;
+        bool first_priority = true;
+        bool first_kind = true;
+        char field[256];
+        forEach([&](Priority priority, LatencyKind kind, const LatencySnapshot& snap) {
+            if (first_priority || priority != current) {
+                if (!first_priority) {
+                    out += "},";
+                }
+                out += "\"";
+                out += priorityName(priority);
+                out += "\":{";
+                current = priority;
+                first_priority = false;
+                first_kind = true;
+            }
+            std::snprintf(field, sizeof(field),
+                "%s\"%s\":{\"count\":%" PRIu64 ",\"mean\":%" PRIu64 ",\"p50\":%" PRIu64
+                ",\"p99\":%" PRIu64 ",\"p999\":%" PRIu64 ",\"max\":%" PRIu64 "}",
+                first_kind ? "" : ",", kindName(kind), snap.count, snap.mean(),
+                snap.percentile(0.5), snap.percentile(0.99), snap.percentile(0.999), snap.max);
+            out += field;
+            first_kind = false;
+        });
+        out += first_priority ? "}" : "}}";
+        return out;
+    }
+
+private:
+    struct Shard {
+        std::array<std::array<LatencyHistogram, kKinds>, kPriorities> histograms;
+    };
+
+    static size_t priorityIndex(Priority priority) {
+        return static_cast<size_t>(priority) - static_cast<size_t>(Priority::LOW);
+    }
+
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const {
+        for (const Priority priority : {Priority::CRITICAL, Priority::HIGH, Priority::NORMAL, Priority::LOW}) {
+            for (const LatencyKind kind : {LatencyKind::QUEUE_WAIT, LatencyKind::EXECUTION, LatencyKind::TOTAL}) {
+                visit(priority, kind, snapshot(kind, priority));
+            }
+        }
+    }
+
+    static const char* priorityName(Priority priority) {
+        switch (priority) {
+            case Priority::CRITICAL: return "CRITICAL";
+            case Priority::HIGH: return "HIGH";
+            case Priority::NORMAL: return "NORMAL";
+            case Priority::LOW: return "LOW";
+            default: return "UNKNOWN";
+        }
+    }
+
+    static const char* kindName(LatencyKind kind) {
+        switch (kind) {
+            case LatencyKind::QUEUE_WAIT: return "queueWait";
+            case LatencyKind::EXECUTION: return "execution";
+            case LatencyKind::TOTAL: return "total";
+            default: return "unknown";
+        }
+    }
+
+    static double micros(uint64_t ns) {
+        return static_cast<double>(ns) / 1000.0;
+    }
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+#endif //FRAME_LATENCYHISTOGRAM_H
@@ -0,0 +1,429 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_LOGRING_H
+#define FRAME_LOGRING_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include "BinaryLog.h"
+#include "ShmStats.h"
+
+using namespace std;
+
+// 环满时的处理方式
+enum class LogOverflowPolicy {
+    BLOCK,          // 等待写线程腾出空间
+    DROP_NEWEST,    // 丢弃当前这条
+    DROP_OLDEST     // 丢弃环中最旧的一条
+};
+
+// 环中的一条日志，定长，超出部分截断
+struct LogRecord {
+    static constexpr size_t kSize = 512;
+    static constexpr size_t kTextSize = kSize - sizeof(spdlog::log_clock::time_point) - 2 * sizeof(uint32_t);
+
+    spdlog::log_clock::time_point time;
+    uint32_t level;
+    uint32_t len;
+    char text[kTextSize];
+};
+
+// 单生产者单消费者环，每个写日志的线程一个
+// DROP_OLDEST 时生产者也会推进 head_：消费者先复制记录再 CAS head_，CAS 失败说明该条已被丢弃、可能已被覆盖，放弃副本
+class ThreadLogRing {
+public:
+    explicit ThreadLogRing(size_t capacity)
+        : mask_(roundUp(capacity) - 1)
+        , slots_(new LogRecord[mask_ + 1])
+        , head_(0)
+        , tail_(0) {}
+
+    ThreadLogRing(const ThreadLogRing &) = delete;
+    void operator=(const ThreadLogRing &) = delete;
+
+    // 生产者调用；writer_running 为 false 时 BLOCK 退化为丢弃，避免写线程停止后永久等待
+    bool push(spdlog::level::level_enum level, spdlog::log_clock::time_point time, std::string_view text,
+              LogOverflowPolicy policy, const std::atomic<bool>& writer_running) {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        while (tail - head > mask_) {
+            if (policy == LogOverflowPolicy::DROP_NEWEST || !writer_running.load(std::memory_order_relaxed)) {
+                dropped_newest_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (policy == LogOverflowPolicy::DROP_OLDEST) {
+                if (head_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel)) {
+                    dropped_oldest_.fetch_add(1, std::memory_order_relaxed);
+                    ++head;
+                }
+                continue;
+            }
+            std::this_thread::yield();
+            head = head_.load(std::memory_order_acquire);
+        }
+
+        LogRecord& record = slots_[tail & mask_];
+        record.time = time;
+        record.level = static_cast<uint32_t>(level);
+        record.len = static_cast<uint32_t>(std::min(text.size(), LogRecord::kTextSize));
+        std::memcpy(record.text, text.data(), record.len);
+        if (text.size() > LogRecord::kTextSize) {
+            std::memcpy(record.text + LogRecord::kTextSize - 3, "...", 3);
+        }
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者调用
+    bool pop(LogRecord& out) {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        while (head != tail_.load(std::memory_order_acquire)) {
+            std::memcpy(static_cast<void*>(&out), &slots_[head & mask_], sizeof(LogRecord));
+            if (head_.compare_exchange_strong(head, head + 1, std::memory_order_acq_rel)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    // 所属线程退出后置位，写线程取空后移除
+    void close() { closed_.store(true, std::memory_order_release); }
+    [[nodiscard]] bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+    [[nodiscard]] uint64_t droppedNewest() const { return dropped_newest_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t droppedOldest() const { return dropped_oldest_.load(std::memory_order_relaxed); }
+
+private:
+    static size_t roundUp(size_t n) {
+        size_t cap = 2;
+        while (cap < n) {
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+    const uint64_t mask_;
+    std::unique_ptr<LogRecord[]> slots_;
+    alignas(64) std::atomic<uint64_t> head_;
+    alignas(64) std::atomic<uint64_t> tail_;
+    alignas(64) std::atomic<uint64_t> dropped_newest_{0};
+    std::atomic<uint64_t> dropped_oldest_{0};
+    std::atomic<bool> closed_{false};
+};
+
+// 写线程的输出端
+class LogRecordSink {
+public:
+    virtual ~LogRecordSink() = default;
+    virtual void write(const LogRecord& record) = 0;
+    virtual void flush() = 0;
+};
+
+// 文本记录交给 spdlog 的 sink，保留记录产生时的时间戳
+class SpdlogRecordSink : public LogRecordSink {
+public:
+    explicit SpdlogRecordSink(std::shared_ptr<spdlog::logger> logger) : logger_(std::move(logger)) {}
+
+    void write(const LogRecord& record) override {
+        logger_->log(record.time, spdlog::source_loc{}, static_cast<spdlog::level::level_enum>(record.level),
+                     spdlog::string_view_t(record.text, record.len));
+    }
+
+    void flush() override {
+        logger_->flush();
+    }
+
+private:
+    std::shared_ptr<spdlog::logger> logger_;
+};
+
+// 二进制记录原样写入滚动文件，由离线工具解码
+class BinaryRecordSink : public LogRecordSink {
+public:
+    BinaryRecordSink(std::string path, size_t max_size, size_t max_files)
+        : file_(std::move(path), max_size, max_files) {}
+
+    void write(const LogRecord& record) override {
+        const auto time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            record.time.time_since_epoch()).count();
+        file_.write(static_cast<int64_t>(time_ns), record.text, record.len);
+    }
+
+    void flush() override {
+        file_.flush();
+    }
+
+private:
+    BinaryLogFile file_;
+};
+
+struct LogRingStats {
+    size_t rings;               // 当前登记的生产者环数
+    uint64_t written;           // 已写入 sink 的条数
+    uint64_t droppedNewest;     // 环满丢弃的新日志
+    uint64_t droppedOldest;     // 环满丢弃的旧日志
+};
+
+// 单写线程：取各线程的环，按时间戳归并后写入 sink；全部取空后置 sleeping_ 睡在条件变量上
+// 生产者只写自己的环，不加锁；只在首次写日志时登记一次，只在写线程睡眠时加锁唤醒
+class LogRingWriter {
+public:
+    LogRingWriter(std::unique_ptr<LogRecordSink> sink, size_t ring_capacity, LogOverflowPolicy policy)
+        : sink_(std::move(sink))
+        , ring_capacity_(std::max<size_t>(ring_capacity, 2))
+        , policy_(policy)
+        , running_(true) {
+        writer_ = std::thread([this]() {
+            this->run();
+        });
+    }
+
+    ~LogRingWriter() {
+        stop();
+    }
+
+    LogRingWriter(const LogRingWriter &) = delete;
+    void operator=(const LogRingWriter &) = delete;
+
+    // 环满且按策略丢弃时返回 false
+    bool push(spdlog::level::level_enum level, std::string_view text) {
+        if (!localRing().push(level, spdlog::log_clock::now(), text, policy_, running_)) {
+            return false;
+        }
+        // 与写线程置 sleeping_ 后的重新检查配对：要么写线程看到本条记录，要么这里看到它在睡眠
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed)) {
+            // 写线程持锁置位并检查，拿到锁时它已进入等待，通知不会丢
+            { std::lock_guard<std::mutex> lock(mutex_); }
+            cv_.notify_one();
+        }
+        return true;
+    }
+
+    // 写完所有已入环的日志后退出写线程，之后的日志按丢弃计数
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) {
+                return;
+            }
+            running_ = false;
+        }
+        cv_.notify_all();
+        if (writer_.joinable()) {
+            writer_.join();
+        }
+        sink_->flush();
+    }
+
+    LogRingStats stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        LogRingStats stats;
+        stats.rings = rings_.size();
+        stats.written = written_.load(std::memory_order_relaxed);
+        stats.droppedNewest = retired_dropped_newest_;
+        stats.droppedOldest = retired_dropped_oldest_;
+        for (const auto& ring : rings_) {
+            stats.droppedNewest += ring->droppedNewest();
+            stats.droppedOldest += ring->droppedOldest();
+        }
+        return stats;
+    }
+
+private:
+    // 线程退出时关闭自己的环；环由写线程持有到取空为止
+    struct LocalRing {
+        std::shared_ptr<ThreadLogRing> ring;
+        LogRingWriter* owner = nullptr;
+
+        ~LocalRing() {
+            if (ring) {
+                ring->close();
+            }
+        }
+    };
+
+    ThreadLogRing& localRing() {
+        thread_local LocalRing local;
+        if (local.owner != this) {
+            if (local.ring) {
+                local.ring->close();
+            }
+            local.ring = std::make_shared<ThreadLogRing>(ring_capacity_);
+            local.owner = this;
+            std::lock_guard<std::mutex> lock(mutex_);
+            rings_.push_back(local.ring);
+            rings_version_.fetch_add(1, std::memory_order_release);
+        }
+        return *local.ring;
+    }
+
+    // 每个环暂存一条已取出的记录，每次写出时间戳最小的一条
+    struct Source {
+        std::shared_ptr<ThreadLogRing> ring;
+        LogRecord record;
+        bool staged = false;
+    };
+
+    void run() {
+        std::vector<Source> sources;
+        uint64_t seen_version = 0;
+        bool dirty = false;
+        while (true) {
+            if (rings_version_.load(std::memory_order_acquire) != seen_version) {
+                refreshSources(sources, seen_version);
+            }
+            const size_t written = drain(sources);
+            publishStats(sources);
+            if (written > 0) {
+                dirty = true;
+                continue;
+            }
+            if (dirty) {
+                sink_->flush();
+                dirty = false;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!running_) {
+                // 停止前的最后一轮：登记表已不再变化，取空即退出
+                lock.unlock();
+                refreshSources(sources, seen_version);
+                if (drain(sources) == 0) {
+                    break;
+                }
+                continue;
+            }
+            sleeping_.store(true, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!pending(sources, seen_version)) {
+                cv_.wait_for(lock, kIdleWait);
+            }
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+        sink_->flush();
+    }
+
+    // 睡眠前的重新检查：已知的环中有记录，或有新登记的环
+    bool pending(const std::vector<Source>& sources, uint64_t seen_version) const {
+        if (rings_version_.load(std::memory_order_acquire) != seen_version) {
+            return true;
+        }
+        return std::any_of(sources.begin(), sources.end(),
+                           [](const Source& source) { return source.staged || !source.ring->empty(); });
+    }
+
+    void refreshSources(std::vector<Source>& sources, uint64_t& seen_version) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        seen_version = rings_version_.load(std::memory_order_acquire);
+        for (const auto& ring : rings_) {
+            const bool known = std::any_of(sources.begin(), sources.end(),
+                                           [&](const Source& s) { return s.ring == ring; });
+            if (!known) {
+                sources.emplace_back();
+                sources.back().ring = ring;
+            }
+        }
+    }
+
+    // 按时间戳归并写出，返回写出的条数；已关闭且取空的环在此移除
+    size_t drain(std::vector<Source>& sources) {
+        size_t written = 0;
+        while (written < kMaxBatch) {
+            Source* next = nullptr;
+            for (auto& source : sources) {
+                if (!source.staged) {
+                    source.staged = source.ring->pop(source.record);
+                }
+                if (source.staged && (!next || source.record.time < next->record.time)) {
+                    next = &source;
+                }
+            }
+            if (!next) {
+                break;
+            }
+            sink_->write(next->record);
+            next->staged = false;
+            ++written;
+        }
+        written_.fetch_add(written, std::memory_order_relaxed);
+        if (written == 0) {
+            retireClosed(sources);
+        }
+        return written;
+    }
+
+    // 只在写线程中调用，retired_* 也只由写线程修改
+    // 写线程通常先于统计段创建，安装统计段后在这里改登记到新段
+    void publishStats(const std::vector<Source>& sources) {
+        if (const uint64_t generation = ShmStats::generation(); generation != stats_generation_) {
+            stats_generation_ = generation;
+            written_stat_ = ShmStats::counter("log.written");
+            dropped_stat_ = ShmStats::counter("log.dropped");
+            rings_stat_ = ShmStats::gauge("log.rings");
+        }
+        uint64_t dropped = retired_dropped_newest_ + retired_dropped_oldest_;
+        for (const auto& source : sources) {
+            dropped += source.ring->droppedNewest() + source.ring->droppedOldest();
+        }
+        written_stat_.set(written_.load(std::memory_order_relaxed));
+        dropped_stat_.set(dropped);
+        rings_stat_.set(sources.size());
+    }
+
+    void retireClosed(std::vector<Source>& sources) {
+        for (size_t i = 0; i < sources.size();) {
+            auto& ring = sources[i].ring;
+            if (!sources[i].staged && ring->closed() && ring->empty()) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                retired_dropped_newest_ += ring->droppedNewest();
+                retired_dropped_oldest_ += ring->droppedOldest();
+                rings_.erase(std::remove(rings_.begin(), rings_.end(), ring), rings_.end());
+                sources[i] = std::move(sources.back());
+                sources.pop_back();
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    static constexpr size_t kMaxBatch = 4096;
+    // 有日志时由生产者唤醒，超时只用于刷新统计与回收已退出线程的环
+    static constexpr std::chrono::milliseconds kIdleWait{100};
+
+    std::unique_ptr<LogRecordSink> sink_;
+    const size_t ring_capacity_;
+    const LogOverflowPolicy policy_;
+    std::atomic<bool> running_;
+    std::atomic<bool> sleeping_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::shared_ptr<ThreadLogRing>> rings_;
+    std::atomic<uint64_t> rings_version_{0};
+    std::atomic<uint64_t> written_{0};
+    uint64_t retired_dropped_newest_ = 0;
+    uint64_t retired_dropped_oldest_ = 0;
+    // 运行时统计，只由写线程登记和写入
+    StatCell written_stat_;
+    StatCell dropped_stat_;
+    StatCell rings_stat_;
+    uint64_t stats_generation_ = ~0ull;
+    std::thread writer_;
+};
+
+#endif //FRAME_LOGRING_H
@@ -5,18 +5,107 @@
 #ifndef FRAME_LOGGER_H
 #define FRAME_LOGGER_H
 
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <mutex>
+#include <type_traits>
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/async.h>
+#include "LogRing.h"
+#include "MmapLogSink.h"
 
+using namespace std;
+
+// 编译期最低日志级别，低于该级别的 LOG 语句连同参数求值一起被编译器消除
+// 0=DEBUG 1=INFO 2=WARN 3=ERROR 4=FATAL
+#ifndef FRAMEJK_LOG_MIN_LEVEL
+#define FRAMEJK_LOG_MIN_LEVEL 0
+#endif
+
+#define LOG_ENABLED_(level) \
+    (static_cast<int>(LogLevel::level) >= FRAMEJK_LOG_MIN_LEVEL && SpdLogger::enabled(LogLevel::level))
+
+// 每个调用点带一个常量初始化的 LogSite，供二进制模式登记
+#define LOG_MESSAGE_(level) \
+    LogMessage(SpdLogger::GetInstance(), LogLevel::level, __FILE_NAME__, __LINE__, \
+        &[]() -> LogSite& { \
+            static LogSite site(__FILE_NAME__, __LINE__, static_cast<int>(LogLevel::level)); \
+            return site; \
+        }())
+
+// 级别在编译期确定；运行期被过滤时不构造 LogMessage，也不对 << 右侧求值
 #define LOG(level) \
-    SpdLogger::GetInstance()->createLogMessage(stringToLogLevel(#level), __FILE_NAME__, __LINE__)
+    !LOG_ENABLED_(level) ? (void)0 : LogVoidify() & LOG_MESSAGE_(level)
+
+// 按调用点限流/采样，状态为调用点上的几个原子量，不加锁
+// 被压制的次数在下一条输出的日志中以 [suppressed N] 报告
+// 展开为完整的 if-else 链，可直接用在不带花括号的 if 分支中
+#define LOG_LIMITER_() ([]() -> LogLimiter& { static LogLimiter limiter; return limiter; }())
+
+#define LOG_ADMITTED_(level, admit) \
+    if (!LOG_ENABLED_(level)) {} \
+    else if (const int64_t log_suppressed_ = (admit); log_suppressed_ < 0) {} \
+    else LogVoidify() & LOG_MESSAGE_(level).suppressed(static_cast<uint64_t>(log_suppressed_))
+
+// 每 n 次输出一次：第 1、n+1、2n+1 ... 次
+#define LOG_EVERY_N(level, n) LOG_ADMITTED_(level, LOG_LIMITER_().everyN(n))
+
+// 前 n 次都输出，之后每 m 次输出一次
+#define LOG_FIRST_N_EVERY_M(level, n, m) LOG_ADMITTED_(level, LOG_LIMITER_().firstNEveryM(n, m))
 
+// 每秒最多输出 n 次
+#define LOG_PER_SECOND(level, n) LOG_ADMITTED_(level, LOG_LIMITER_().perSecond(n))
+
+// 调用点限流状态，常量初始化；返回值小于 0 表示本次被压制，否则为上次输出以来被压制的次数
+struct LogLimiter {
+    std::atomic<uint64_t> count{0};             // 累计调用次数
+    std::atomic<uint64_t> suppressed{0};        // 上次输出以来被压制的次数
+    std::atomic<int64_t> window{-1};            // perSecond 当前所在的秒
+    std::atomic<uint64_t> window_count{0};      // 当前秒内已输出的次数
+
+    constexpr LogLimiter() = default;
+
+    int64_t everyN(uint64_t n) {
+        const uint64_t c = count.fetch_add(1, std::memory_order_relaxed);
+        return n <= 1 || c % n == 0 ? admit() : reject();
+    }
+
+    int64_t firstNEveryM(uint64_t n, uint64_t m) {
+        const uint64_t c = count.fetch_add(1, std::memory_order_relaxed);
+        return c < n || (m > 0 && (c - n + 1) % m == 0) ? admit() : reject();
+    }
+
+    // 换秒时重置计数，并发换秒时可能多放行几条
+    int64_t perSecond(uint64_t n) {
+        const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t current = window.load(std::memory_order_relaxed);
+        if (current != now && window.compare_exchange_strong(current, now, std::memory_order_relaxed)) {
+            window_count.store(0, std::memory_order_relaxed);
+        }
+        return window_count.fetch_add(1, std::memory_order_relaxed) < n ? admit() : reject();
+    }
+
+private:
+    int64_t admit() {
+        return static_cast<int64_t>(suppressed.exchange(0, std::memory_order_relaxed));
+    }
+
+    int64_t reject() {
+        suppressed.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+};
 
 enum class LogLevel {
     DEBUG,
@@ -49,7 +138,15 @@ struct LoggerConfig {
     size_t maxFiles;               // 最大日志文件数量
     bool asyncMode;                // 是否使用异步模式
     bool consoleOutput;            // 是否输出到控制台
+    bool fileOutput;               // 是否写日志文件，命令行客户端关闭，避免写入服务进程的日志
     std::string pattern;           // 日志格式模式
+    bool ringMode;                 // 每线程无锁环 + 单写线程，开启时忽略 asyncMode
+    size_t ringCapacity;           // 每个线程环的条数
+    LogOverflowPolicy overflowPolicy;  // 环满时的处理
+    bool binaryMode;               // 二进制日志写入 logPath.bin，用 LogDecode 解码；使用环形写线程，忽略 asyncMode 与 consoleOutput
+    bool mmapSink;                 // 文件写入预分配的 mmap 段 logPath.0 ... logPath.(maxFiles-1)，替代 rotating_file_sink
+    size_t syncInterval;           // mmapSink 下后台 msync 的间隔（毫秒），0 表示只在 flush 时落盘
+    bool syncOnFatal;              // mmapSink 下 FATAL 日志写入后立即 msync
 
     LoggerConfig() :
         minLogLevel(LogLevel::DEBUG),
@@ -57,35 +154,232 @@ struct LoggerConfig {
         maxFiles(10),
         asyncMode(true),
         consoleOutput(true),
-        pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] %v") {}
+        fileOutput(true),
+        pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] %v"),
+        ringMode(false),
+        ringCapacity(1024),
+        overflowPolicy(LogOverflowPolicy::BLOCK),
+        binaryMode(false),
+        mmapSink(false),
+        syncInterval(1000),
+        syncOnFatal(true) {}
 };
 
 class SpdLogger;
 
-// 输出一个日志类
+// 每个线程的格式化缓冲区，按嵌套深度使用（参数求值时再次打日志会进入下一层）
+struct LogBuffer {
+    static constexpr size_t kSize = 2048;
+    static constexpr size_t kDepth = 4;
+
+    char data[kSize];
+    size_t len;
+    bool truncated;
+};
+
+struct LogBufferStack {
+    LogBuffer buffers[LogBuffer::kDepth];
+    size_t depth = 0;
+};
+
+inline LogBufferStack& logBufferStack() {
+    thread_local LogBufferStack stack;
+    return stack;
+}
+
+// 嵌套过深时返回空，该条日志只输出占位文本
+inline LogBuffer* acquireLogBuffer() {
+    LogBufferStack& stack = logBufferStack();
+    if (stack.depth >= LogBuffer::kDepth) {
+        return nullptr;
+    }
+    LogBuffer* buffer = &stack.buffers[stack.depth++];
+    buffer->len = 0;
+    buffer->truncated = false;
+    return buffer;
+}
+
+inline void releaseLogBuffer() {
+    --logBufferStack().depth;
+}
+
+// 输出一个日志类，格式化到线程局部的定长缓冲区，不分配堆内存，超长部分截断
+// 二进制模式下不格式化，只按类型追加参数的原始字节，文件名、行号和参数类型由调用点登记一次
 class LogMessage {
 public:
     LogMessage(SpdLogger* loggerMethod, const LogLevel level,
-        const char* file = __FILE_NAME__, const int line = __LINE__) :
-        loggerMethod_(loggerMethod), level_(level){
-        stream_ << "[" << file << ":" << line << "] ";
-    }
+        const char* file = __FILE_NAME__, const int line = __LINE__, LogSite* site = nullptr);
 
     ~LogMessage();
 
+    LogMessage(const LogMessage &) = delete;
+    void operator=(const LogMessage &) = delete;
+
     template <typename T>
     LogMessage& operator<<(const T& msg) {
-        stream_ << msg;
+        using U = std::decay_t<T>;
+        if (site_) {
+            encode(msg);
+        } else if constexpr (std::is_same_v<U, bool>) {
+            append(msg ? "1" : "0", 1);
+        } else if constexpr (std::is_same_v<U, char>) {
+            append(&msg, 1);
+        } else if constexpr (std::is_integral_v<U>) {
+            char digits[24];
+            const auto result = std::to_chars(digits, digits + sizeof(digits), msg);
+            append(digits, static_cast<size_t>(result.ptr - digits));
+        } else if constexpr (std::is_floating_point_v<U>) {
+            char digits[32];
+            const int n = std::snprintf(digits, sizeof(digits), "%g", static_cast<double>(msg));
+            append(digits, n > 0 ? std::min(static_cast<size_t>(n), sizeof(digits) - 1) : 0);
+        } else if constexpr (std::is_enum_v<U>) {
+            *this << static_cast<std::underlying_type_t<U>>(msg);
+        } else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) {
+            const std::string_view text = cString(msg);
+            append(text.data(), text.size());
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            const std::string_view text(msg);
+            append(text.data(), text.size());
+        } else if constexpr (std::is_pointer_v<U>) {
+            char digits[24];
+            const int n = std::snprintf(digits, sizeof(digits), "%p", static_cast<const void*>(msg));
+            append(digits, n > 0 ? std::min(static_cast<size_t>(n), sizeof(digits) - 1) : 0);
+        } else {
+            // 其它类型沿用 operator<<(ostream&)，会分配内存，热路径上应避免
+            thread_local std::ostringstream fallback;
+            fallback.str(std::string());
+            fallback << msg;
+            const std::string text = fallback.str();
+            append(text.data(), text.size());
+        }
         return *this;
     }
 
-    std::string str() const {return stream_.str();}
+    [[nodiscard]] std::string_view str() const {
+        return buffer_ ? std::string_view(buffer_->data, buffer_->len) : std::string_view("[log nested too deep]");
+    }
     LogLevel level() const {return level_;}
+    [[nodiscard]] bool binary() const { return site_ != nullptr; }
+
+    // 限流宏使用：报告被压制的次数，文本模式下为 0 时不输出
+    LogMessage& suppressed(uint64_t count) {
+        if (site_) {
+            encodeValue(LOG_ARG_SUPPRESSED, count);
+        } else if (count > 0) {
+            *this << std::string_view("[suppressed ") << count << std::string_view("] ");
+        }
+        return *this;
+    }
 
 private:
+    // C 字符串参数：字符数组（如字面量）的地址不可能为空，直接转换；只有真正的指针才检查空
+    template <typename T>
+    static std::string_view cString(const T& msg) {
+        if constexpr (std::is_array_v<std::remove_reference_t<T>>) {
+            return std::string_view(msg);
+        } else {
+            return msg ? std::string_view(msg) : std::string_view("(null)");
+        }
+    }
+
+    // 二进制载荷不超过环中一条记录的容量，装不下的参数只登记类型不写入
+    static constexpr size_t kBinaryLimit = std::min(LogBuffer::kSize, LogRecord::kTextSize);
+
+    template <typename T>
+    void encode(const T& msg) {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_same_v<U, bool>) {
+            encodeValue(LOG_ARG_BOOL, static_cast<uint8_t>(msg ? 1 : 0));
+        } else if constexpr (std::is_same_v<U, char>) {
+            encodeValue(LOG_ARG_CHAR, msg);
+        } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+            encodeValue(LOG_ARG_INT, static_cast<int64_t>(msg));
+        } else if constexpr (std::is_integral_v<U>) {
+            encodeValue(LOG_ARG_UINT, static_cast<uint64_t>(msg));
+        } else if constexpr (std::is_floating_point_v<U>) {
+            encodeValue(LOG_ARG_DOUBLE, static_cast<double>(msg));
+        } else if constexpr (std::is_enum_v<U>) {
+            encode(static_cast<std::underlying_type_t<U>>(msg));
+        } else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) {
+            encodeString(cString(msg));
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            encodeString(std::string_view(msg));
+        } else if constexpr (std::is_pointer_v<U>) {
+            encodeValue(LOG_ARG_POINTER, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(msg)));
+        } else {
+            thread_local std::ostringstream fallback;
+            fallback.str(std::string());
+            fallback << msg;
+            encodeString(fallback.str());
+        }
+    }
+
+    bool addTag(char tag) {
+        if (tag_count_ >= kBinaryMaxArgs) {
+            return false;
+        }
+        tags_[tag_count_++] = tag;
+        return buffer_ && !buffer_->truncated;
+    }
+
+    template <typename T>
+    void encodeValue(char tag, const T& value) {
+        if (!addTag(tag)) {
+            return;
+        }
+        if (buffer_->len + sizeof(T) > kBinaryLimit) {
+            buffer_->truncated = true;
+            return;
+        }
+        std::memcpy(buffer_->data + buffer_->len, &value, sizeof(T));
+        buffer_->len += sizeof(T);
+        ++arg_count_;
+    }
+
+    void encodeString(std::string_view text) {
+        if (!addTag(LOG_ARG_STRING)) {
+            return;
+        }
+        if (buffer_->len + sizeof(uint16_t) >= kBinaryLimit) {
+            buffer_->truncated = true;
+            return;
+        }
+        size_t n = std::min<size_t>(text.size(), kBinaryLimit - buffer_->len - sizeof(uint16_t));
+        if (n < text.size()) {
+            buffer_->truncated = true;
+        }
+        const auto len = static_cast<uint16_t>(n);
+        std::memcpy(buffer_->data + buffer_->len, &len, sizeof(len));
+        std::memcpy(buffer_->data + buffer_->len + sizeof(len), text.data(), n);
+        buffer_->len += sizeof(len) + n;
+        ++arg_count_;
+    }
+
+    void append(const char* data, size_t n) {
+        if (!buffer_) {
+            return;
+        }
+        const size_t room = LogBuffer::kSize - buffer_->len;
+        if (n > room) {
+            n = room;
+            buffer_->truncated = true;
+        }
+        std::memcpy(buffer_->data + buffer_->len, data, n);
+        buffer_->len += n;
+    }
+
     SpdLogger* loggerMethod_;
-    std::ostringstream stream_;
     LogLevel level_;
+    LogBuffer* buffer_;
+    LogSite* site_;
+    uint8_t arg_count_;
+    uint8_t tag_count_;
+    char tags_[kBinaryMaxArgs];
+};
+
+// 让 LOG 宏两个分支的类型都为 void，& 的优先级低于 <<
+struct LogVoidify {
+    void operator&(const LogMessage&) {}
 };
 
 class SpdLogger {
@@ -106,13 +400,32 @@ public:
     void initialize() {
         std::vector<spdlog::sink_ptr> sinks;
 
+        if (conf_->binaryMode) {
+            // 不经过 spdlog 的 sink，logger_ 只为 flush 等接口保留
+            logger_ = std::make_shared<spdlog::logger>("binary_logger");
+            ring_writer_ = std::make_unique<LogRingWriter>(
+                std::make_unique<BinaryRecordSink>(conf_->logPath + ".bin", conf_->maxFileSize, conf_->maxFiles),
+                conf_->ringCapacity, conf_->overflowPolicy);
+            return;
+        }
+
         // 文件
-        auto file_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
-            conf_->logPath,
-            conf_->maxFileSize,
-            conf_->maxFiles
-        );
-        sinks.push_back(file_sink);
+        if (conf_->fileOutput && conf_->mmapSink) {
+            mmap_sink_ = std::make_shared<MmapFileSink>(
+                conf_->logPath,
+                conf_->maxFileSize,
+                conf_->maxFiles,
+                std::chrono::milliseconds(conf_->syncInterval),
+                conf_->syncOnFatal);
+            sinks.push_back(mmap_sink_);
+        } else if (conf_->fileOutput) {
+            auto file_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+                conf_->logPath,
+                conf_->maxFileSize,
+                conf_->maxFiles
+            );
+            sinks.push_back(file_sink);
+        }
         // 控制台
         if (conf_->consoleOutput) {
             auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
@@ -120,7 +433,15 @@ public:
         }
 
         // 创建
-        if (conf_->asyncMode) {
+        if (conf_->ringMode) {
+            // 写线程同步调用 sink，不再经过 spdlog 的异步队列
+            logger_ = std::make_shared<spdlog::logger>(
+                "ring_logger",
+                sinks.begin(),
+                sinks.end());
+            ring_writer_ = std::make_unique<LogRingWriter>(
+                std::make_unique<SpdlogRecordSink>(logger_), conf_->ringCapacity, conf_->overflowPolicy);
+        } else if (conf_->asyncMode) {
             logger_ = std::make_shared<spdlog::async_logger>(
                 "async_logger",
                 sinks.begin(),
@@ -142,28 +463,27 @@ public:
         if (!shouldLog(message.level())) {
             return;
         }
-        std::lock_guard<std::mutex> lock(mutex_);
-        switch (message.level()) {
-            case LogLevel::DEBUG:
-                logger_->debug(message.str());
-                break;
-            case LogLevel::INFO:
-                logger_->info(message.str());
-                break;
-            case LogLevel::WARN:
-                logger_->warn(message.str());
-                break;
-            case LogLevel::ERROR:
-                logger_->error(message.str());
-                break;
-            case LogLevel::FATAL:
-                logger_->critical(message.str());
-                break;
+        const std::string_view text = message.str();
+        if (message.binary() != binaryMode()) {
+            // 未带调用点的 LogMessage 无法写入二进制文件
+            return;
+        }
+        if (ring_writer_) {
+            ring_writer_->push(convertLevel(message.level()), text);
+            return;
         }
+        std::lock_guard<std::mutex> lock(mutex_);
+        logger_->log(convertLevel(message.level()), spdlog::string_view_t(text.data(), text.size()));
     }
 
     void flush() const {
+        if (ring_writer_) {
+            ring_writer_->stop();
+        }
         logger_->flush();
+        if (mmap_sink_) {
+            mmap_sink_->close();
+        }
         spdlog::shutdown();
     }
 
@@ -171,12 +491,39 @@ public:
         logger_->set_pattern(pattern);
     }
 
-    // 便捷日志方法
-    LogMessage createLogMessage(LogLevel level, const char* file, int line) {
-        return LogMessage(this, level, file, line);
+    static void set_config(LoggerConfig *conf);
+
+    // 运行期调整最低级别，配置热加载时调用
+    void setMinLevel(LogLevel level) {
+        min_level_.store(static_cast<int>(level), std::memory_order_relaxed);
+        logger_->set_level(convertLevel(level));
     }
 
-    static void set_config(LoggerConfig *conf);
+    // fork 出的子进程中调用：父进程的写线程与 spdlog 线程池不会随 fork 复制，旧实例弃用且不析构
+    // （其中的锁可能在 fork 时被其他线程持有），之后的日志由新实例写入 logPath + suffix，不与父进程共用轮转文件
+    static void reopenAfterFork(const std::string& suffix) {
+        auto* conf = new LoggerConfig(*conf_);
+        conf->logPath += suffix;
+        set_config(conf);
+        instance = nullptr;
+    }
+
+    // ringMode 下的写入与丢弃计数，其它模式返回全 0
+    LogRingStats ringStats() const {
+        if (ring_writer_) {
+            return ring_writer_->stats();
+        }
+        return LogRingStats{};
+    }
+
+    // 运行期级别过滤，LOG 宏在构造 LogMessage 之前调用，不触发初始化
+    static bool enabled(LogLevel level) {
+        return static_cast<int>(level) >= min_level_.load(std::memory_order_relaxed);
+    }
+
+    static bool binaryMode() {
+        return binary_mode_.load(std::memory_order_relaxed);
+    }
 
 protected:
     explicit SpdLogger() {
@@ -191,7 +538,11 @@ private:
     static SpdLogger *instance;
     const shared_ptr<spdlog::details::thread_pool> thread_pool = std::make_shared<spdlog::details::thread_pool>(8192, 1);
     std::shared_ptr<spdlog::logger> logger_;
+    std::unique_ptr<LogRingWriter> ring_writer_;
+    std::shared_ptr<MmapFileSink> mmap_sink_;
     static LoggerConfig *conf_;
+    inline static std::atomic<int> min_level_{0};
+    inline static std::atomic<bool> binary_mode_{false};
     std::mutex mutex_;
     static spdlog::level::level_enum convertLevel(LogLevel level) {
         switch (level) {
@@ -210,18 +561,45 @@ private:
         }
     }
     [[nodiscard]] bool shouldLog(LogLevel level) {
-        return level >= conf_->minLogLevel;
+        return enabled(level);
     }
 };
 
 inline LogMessage::~LogMessage() {
+    if (site_ && buffer_) {
+        uint32_t id = site_->id.load(std::memory_order_acquire);
+        if (id == 0) {
+            id = logSiteRegistry().registerSite(*site_, std::string_view(tags_, tag_count_));
+        }
+        std::memcpy(buffer_->data, &id, sizeof(id));
+        buffer_->data[sizeof(id)] = static_cast<char>(arg_count_);
+    } else if (buffer_ && buffer_->truncated && buffer_->len >= 3) {
+        std::memcpy(buffer_->data + buffer_->len - 3, "...", 3);
+    }
     if (loggerMethod_) {
         loggerMethod_->log(*this);
     }
+    if (buffer_) {
+        releaseLogBuffer();
+    }
 }
 
 inline void SpdLogger::set_config(LoggerConfig* conf) {
     conf_ = conf;
+    min_level_.store(static_cast<int>(conf->minLogLevel), std::memory_order_relaxed);
+    binary_mode_.store(conf->binaryMode, std::memory_order_relaxed);
+}
+
+inline LogMessage::LogMessage(SpdLogger* loggerMethod, const LogLevel level,
+    const char* file, const int line, LogSite* site) :
+    loggerMethod_(loggerMethod), level_(level), buffer_(acquireLogBuffer()),
+    site_(site && buffer_ && SpdLogger::binaryMode() ? site : nullptr), arg_count_(0), tag_count_(0) {
+    if (site_) {
+        // 载荷头：调用点 id 与参数个数，析构时填写
+        buffer_->len = kBinaryPayloadHeader;
+        return;
+    }
+    *this << "[" << file << ":" << line << "] ";
 }
 
 LoggerConfig* SpdLogger::conf_ = nullptr;
@@ -0,0 +1,299 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_MMAPLOGSINK_H
+#define FRAME_MMAPLOGSINK_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <spdlog/sinks/base_sink.h>
+
+using namespace std;
+
+// 预分配并 mmap 的日志段，写入即内存拷贝
+// 最后一个引用释放时解除映射，并把文件截断到实际写入长度
+struct MmapLogSegment {
+    int fd;
+    char* data;
+    size_t capacity;
+    size_t size;
+
+    MmapLogSegment() : fd(-1), data(nullptr), capacity(0), size(0) {}
+
+    ~MmapLogSegment() {
+        if (data) {
+            munmap(data, capacity);
+        }
+        if (fd >= 0) {
+            if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                // 截断失败时文件尾部保留预分配的 0 字节
+            }
+            // 通过映射写入不保证更新修改时间，封段时显式更新，供按修改时间排序
+            futimens(fd, nullptr);
+            close(fd);
+        }
+    }
+
+    MmapLogSegment(const MmapLogSegment &) = delete;
+    void operator=(const MmapLogSegment &) = delete;
+
+    // 清空并预分配 capacity 字节后映射，失败返回 nullptr
+    static std::shared_ptr<MmapLogSegment> create(const string& path, size_t capacity) {
+        auto segment = std::make_shared<MmapLogSegment>();
+        segment->fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (segment->fd < 0) {
+            return nullptr;
+        }
+#ifdef __linux__
+        const bool allocated = fallocate(segment->fd, 0, 0, static_cast<off_t>(capacity)) == 0
+            || posix_fallocate(segment->fd, 0, static_cast<off_t>(capacity)) == 0;
+#else
+        const bool allocated = ftruncate(segment->fd, static_cast<off_t>(capacity)) == 0;
+#endif
+        if (!allocated) {
+            return nullptr;
+        }
+#ifdef MAP_POPULATE
+        // 预先建立页表，写入时不再触发缺页；段在后台线程创建，开销不在写路径上
+        constexpr int flags = MAP_SHARED | MAP_POPULATE;
+#else
+        constexpr int flags = MAP_SHARED;
+#endif
+        void* data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, flags, segment->fd, 0);
+        if (data == MAP_FAILED) {
+            return nullptr;
+        }
+        segment->data = static_cast<char*>(data);
+        segment->capacity = capacity;
+        // 共享文件映射首次写页时仍会因脏页跟踪缺页，预先写一遍把这次缺页也移出写路径
+        const long page = sysconf(_SC_PAGESIZE);
+        for (size_t offset = 0; offset < capacity; offset += static_cast<size_t>(page)) {
+            static_cast<volatile char*>(data)[offset] = 0;
+        }
+        return segment;
+    }
+
+    // 把 [0, len) 同步落盘
+    void sync(size_t len) const {
+        if (data && len > 0) {
+            msync(data, len, MS_SYNC);
+        }
+    }
+};
+
+// 基于 mmap 的轮转文件 sink，替代 rotating_file_sink_mt
+// 段文件为 path.0 ... path.(N-1)，循环复用，已封段按修改时间排序即为写入顺序
+// 每段预先 fallocate 到 maxFileSize，写满后切换到后台线程预先建好的下一段，不做 rename
+// 下一段在切换前就被清空，因此保留的历史为 N-2 个满段加当前段
+// 进程异常退出时当前段尾部为预分配的 0 字节，读取时遇到 '\0' 即为结尾
+// 持久性：syncInterval 大于 0 时后台线程定期 msync，syncOnFatal 时 FATAL 日志写入后立即 msync
+class MmapFileSink : public spdlog::sinks::base_sink<std::mutex> {
+public:
+    MmapFileSink(string path, size_t segment_size, size_t segments,
+                 std::chrono::milliseconds sync_interval, bool sync_on_fatal)
+        : path_(std::move(path))
+        , segment_size_(std::max<size_t>(segment_size, 4096))
+        , segments_(std::max<size_t>(segments, 2))
+        , sync_interval_(sync_interval)
+        , sync_on_fatal_(sync_on_fatal)
+        , index_(firstIndex())
+        , preparing_(false)
+        , stop_(false) {
+        current_ = MmapLogSegment::create(segmentPath(index_), segment_size_);
+        if (!current_) {
+            throw spdlog::spdlog_ex("mmap log segment create failed: " + segmentPath(index_), errno);
+        }
+        next_ = MmapLogSegment::create(segmentPath((index_ + 1) % segments_), segment_size_);
+        published_ = current_;
+        worker_ = std::thread(&MmapFileSink::maintain, this);
+    }
+
+    ~MmapFileSink() override {
+        close();
+    }
+
+    // 停止后台线程，当前段落盘并截断到实际长度，删除尚未写入的预建段；之后的日志被丢弃
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            stop_ = true;
+        }
+        state_cv_.notify_all();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        if (current_) {
+            current_->sync(current_->size);
+            current_.reset();
+        }
+        published_.reset();
+        retired_.clear();
+        if (next_) {
+            next_.reset();
+            unlink(segmentPath((index_ + 1) % segments_).c_str());
+        }
+    }
+
+    [[nodiscard]] string segmentPath(size_t index) const {
+        return path_ + "." + std::to_string(index);
+    }
+
+protected:
+    void sink_it_(const spdlog::details::log_msg& msg) override {
+        if (closed_) {
+            return;
+        }
+        spdlog::memory_buf_t formatted;
+        formatter_->format(msg, formatted);
+        const size_t len = std::min(formatted.size(), segment_size_);
+        if (!current_ || current_->size + len > current_->capacity) {
+            rotate();
+            if (!current_) {
+                return;
+            }
+        }
+        std::memcpy(current_->data + current_->size, formatted.data(), len);
+        current_->size += len;
+        if (sync_on_fatal_ && msg.level >= spdlog::level::critical) {
+            current_->sync(current_->size);
+        }
+    }
+
+    // 写入映射后数据已在页缓存中，对其他进程可见，进程崩溃也不丢失，flush 无需系统调用
+    // 落盘由 syncInterval 与 syncOnFatal 控制
+    void flush_() override {}
+
+private:
+    // 从最近写过的段之后开始，避免覆盖上次运行的最新日志
+    [[nodiscard]] size_t firstIndex() const {
+        size_t newest = segments_ - 1;
+        struct timespec newest_time = {0, 0};
+        for (size_t i = 0; i < segments_; ++i) {
+            struct stat st{};
+            if (stat(segmentPath(i).c_str(), &st) != 0) {
+                continue;
+            }
+#ifdef __APPLE__
+            const struct timespec mtime = st.st_mtimespec;
+#else
+            const struct timespec mtime = st.st_mtim;
+#endif
+            if (mtime.tv_sec > newest_time.tv_sec
+                || (mtime.tv_sec == newest_time.tv_sec && mtime.tv_nsec > newest_time.tv_nsec)) {
+                newest_time = mtime;
+                newest = i;
+            }
+        }
+        return (newest + 1) % segments_;
+    }
+
+    // 在 base_sink 的锁内调用
+    void rotate() {
+        index_ = (index_ + 1) % segments_;
+        std::shared_ptr<MmapLogSegment> next;
+        {
+            std::unique_lock<std::mutex> lock(state_mutex_);
+            // 下一段正在后台创建时等待，不能同时对同一文件 O_TRUNC
+            state_cv_.wait(lock, [this] { return !preparing_ || stop_; });
+            next = std::move(next_);
+            if (current_) {
+                retired_.push_back(std::move(current_));
+            }
+        }
+        if (!next) {
+            // 后台预建失败，退化为同步创建
+            next = MmapLogSegment::create(segmentPath(index_), segment_size_);
+        }
+        current_ = std::move(next);
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            published_ = current_;
+            next_index_ = (index_ + 1) % segments_;
+            preparing_ = true;
+        }
+        state_cv_.notify_all();
+    }
+
+    // 后台线程：预建下一段，同步并回收旧段，定期 msync 当前段
+    void maintain() {
+        std::unique_lock<std::mutex> lock(state_mutex_);
+        while (!stop_) {
+            const auto ready = [this] { return stop_ || preparing_ || !retired_.empty(); };
+            if (sync_interval_.count() > 0) {
+                state_cv_.wait_for(lock, sync_interval_, ready);
+            } else {
+                state_cv_.wait(lock, ready);
+            }
+            if (stop_) {
+                break;
+            }
+            std::vector<std::shared_ptr<MmapLogSegment>> retired;
+            retired.swap(retired_);
+            const bool prepare = preparing_;
+            const size_t next_index = next_index_;
+            std::shared_ptr<MmapLogSegment> current = published_;
+            lock.unlock();
+
+            if (prepare) {
+                auto next = MmapLogSegment::create(segmentPath(next_index), segment_size_);
+                lock.lock();
+                next_ = std::move(next);
+                preparing_ = false;
+                lock.unlock();
+                state_cv_.notify_all();
+            }
+            // 旧段在写线程之外同步、解除映射和截断
+            for (auto& segment : retired) {
+                segment->sync(segment->size);
+            }
+            retired.clear();
+            if (sync_interval_.count() > 0 && current) {
+                size_t size;
+                {
+                    std::lock_guard<std::mutex> sink_lock(mutex_);
+                    size = current->size;
+                }
+                current->sync(size);
+            }
+            lock.lock();
+        }
+    }
+
+    const string path_;
+    const size_t segment_size_;
+    const size_t segments_;
+    const std::chrono::milliseconds sync_interval_;
+    const bool sync_on_fatal_;
+
+    // 由 base_sink 的锁保护
+    size_t index_;
+    bool closed_ = false;
+    std::shared_ptr<MmapLogSegment> current_;
+
+    // 与后台线程共享，由 state_mutex_ 保护
+    std::mutex state_mutex_;
+    std::condition_variable state_cv_;
+    std::shared_ptr<MmapLogSegment> next_;
+    std::shared_ptr<MmapLogSegment> published_;
+    std::vector<std::shared_ptr<MmapLogSegment>> retired_;
+    size_t next_index_ = 0;
+    bool preparing_;
+    bool stop_;
+    std::thread worker_;
+};
+
+#endif //FRAME_MMAPLOGSINK_H
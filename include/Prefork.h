@@ -0,0 +1,585 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_PREFORK_H
+#define FRAME_PREFORK_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "CreateShare.h"
+#include "Logger.h"
+#include "ShmTaskChannel.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// 预派生模式配置
+struct PreforkConfig {
+    size_t workers;                             // 工作进程数，不超过 CtrlShared::kMaxWorkers
+    size_t threadsPerWorker;                    // 每个工作进程的线程数，任务代码非线程安全时为 1
+    size_t prefetch;                            // 每个工作进程在执行中的任务之外最多预取的任务数
+    int channelId;                              // 任务通道编号，生产者用 ShmTaskProducer 写入同一通道
+    string sharePath;                           // 任务通道的共享段路径
+    bool hugePages;
+    std::chrono::milliseconds heartbeatInterval;   // 工作进程心跳与主进程巡检的间隔
+    std::chrono::milliseconds heartbeatTimeout;    // 心跳超过该时长未更新的工作进程被杀死后重启
+    std::chrono::milliseconds drainTimeout;        // 停止时工作进程排空本地任务的时长
+
+    PreforkConfig() :
+        workers(4),
+        threadsPerWorker(1),
+        prefetch(15),
+        channelId(16),
+        sharePath("/tmp"),
+        hugePages(false),
+        heartbeatInterval(100),
+        heartbeatTimeout(3000),
+        drainTimeout(5000) {}
+};
+
+// 预派生的主进程：经 zygote fork 出若干工作进程，各自运行一个 ThreadPool，共同消费一个共享内存任务通道
+// 工作进程只取自己能马上执行的量（执行中 + prefetch），空闲的进程先取到任务，负载随之均衡
+// 状态经 CtrlShared 的 workers 表交换：工作进程写心跳与负载，主进程巡检，日志级别经 workerLogLevel 下发
+// 进程异常退出或心跳超时（先 SIGKILL）后在同一槽位重启；一个任务崩溃只影响所在工作进程已取出的任务
+// 主进程有日志、控制、巡检等线程，在其中 fork 时其他线程持有的锁（malloc、日志）会原样留在子进程里
+// 所以 prepare 在任何线程创建之前先 fork 出单线程的 zygote，之后所有工作进程（含重启）都由 zygote fork，
+// 主进程与 zygote 之间经一对 socket 传递派生请求与派生、退出事件；日志在工作进程中重新打开，写入 logPath.worker<N>
+// 主进程退出后 zygote 随之退出，工作进程发现父进程变化后排空退出
+// 工作进程在 tryConsumeShared 的 visit 期间被杀死（心跳超时的 SIGKILL 或崩溃）时所占槽位不再释放，
+// 生产者绕回后一直看到通道满，通道对所有生产者卡死，只能停止服务、删除通道后重建；visit 中因此只复制记录
+class PreforkMaster {
+public:
+    // shared 须位于 prepare 之前已建立的共享映射中（CommentCtrl 的控制段），zygote 与工作进程经 fork 继承
+    // worker_init 在工作进程重新打开日志后、开始取任务前执行，补做主进程在 prepare 之后才做的初始化
+    PreforkMaster(const PreforkConfig& conf, CtrlShared& shared, ShmTaskConsumer::Handler handler,
+                  std::function<void()> worker_init = {}) :
+        conf_(conf),
+        shared_(shared),
+        handler_(std::move(handler)),
+        worker_init_(std::move(worker_init)),
+        channel_(conf.channelId, OWN_RW_OTH_RW, conf.sharePath, shmChannelOptions(conf.hugePages)),
+        master_pid_(getpid()) {
+        conf_.workers = std::min<size_t>(std::max<size_t>(conf_.workers, 1), CtrlShared::kMaxWorkers);
+        conf_.threadsPerWorker = std::max<size_t>(conf_.threadsPerWorker, 1);
+        pids_.assign(conf_.workers, 0);
+    }
+
+    ~PreforkMaster() {
+        stop();
+    }
+
+    PreforkMaster(const PreforkMaster &) = delete;
+    void operator=(const PreforkMaster &) = delete;
+
+    // fork 出 zygote，必须在本进程创建任何线程之前调用，第一次写日志也会创建日志线程
+    // 成功路径上不写日志；start 时尚未调用则在 start 中调用；本进程已有其他线程时拒绝 fork 并返回 false
+    bool prepare() {
+        if (zygote_ > 0) {
+            return true;
+        }
+        if (!channel_.valid()) {
+            LOG(ERROR) << "Prefork channel " << conf_.channelId << " unavailable under " << conf_.sharePath;
+            return false;
+        }
+        if (const size_t threads = threadCount(); threads != 1) {
+            LOG(ERROR) << "Prefork zygote must be forked from a single-threaded process, found " << threads
+                       << " threads; something started a thread or wrote a log before prepare";
+            return false;
+        }
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) != 0) {
+            LOG(ERROR) << "Prefork zygote socketpair failed: " << strerror(errno);
+            return false;
+        }
+        const pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            socket_ = fds[1];
+            zygote_ = getpid();
+            _exit(runZygote());
+        }
+        close(fds[1]);
+        if (pid < 0) {
+            close(fds[0]);
+            LOG(ERROR) << "Prefork zygote fork failed: " << strerror(errno);
+            return false;
+        }
+        zygote_ = pid;
+        socket_ = fds[0];
+        lost_ = false;
+        return true;
+    }
+
+    // 通道不可用或派生失败时返回 false，已启动的工作进程由 stop 回收
+    bool start() {
+        if (!prepare()) {
+            return false;
+        }
+        warnHugePageFallback(channel_, conf_.hugePages);
+        stopped_.store(false, std::memory_order_release);
+        shared_.workerStop.store(0, std::memory_order_release);
+        shared_.workerCount.store(static_cast<uint32_t>(conf_.workers), std::memory_order_release);
+        for (size_t i = 0; i < conf_.workers; ++i) {
+            CtrlWorker& worker = shared_.workers[i];
+            worker.completed.store(0, std::memory_order_relaxed);
+            worker.dropped.store(0, std::memory_order_relaxed);
+            worker.restarts.store(0, std::memory_order_relaxed);
+            if (!spawn(i)) {
+                return false;
+            }
+        }
+        supervisor_ = std::thread([this]() { supervise(); });
+        LOG(INFO) << "Prefork started " << conf_.workers << " workers x " << conf_.threadsPerWorker
+                  << " threads on channel " << channel_.name() << ", zygote pid " << zygote_;
+        return true;
+    }
+
+    // 通知工作进程停止取任务、排空后退出，等待 drainTimeout 加一个巡检间隔，仍未退出的 SIGKILL
+    // 之后关闭请求方向，zygote 回收完工作进程后退出；通道中未取出的记录留在共享内存中；全部正常退出时返回 true
+    bool stop() {
+        if (zygote_ <= 0) {
+            return true;
+        }
+        stopped_.store(true, std::memory_order_release);
+        if (supervisor_.joinable()) {
+            supervisor_.join();
+        }
+        shared_.workerStop.store(1, std::memory_order_release);
+        channel_.get()->wakeConsumer();
+        shutdown(socket_, SHUT_WR);
+
+        bool clean = true;
+        bool killed = false;
+        auto deadline = std::chrono::steady_clock::now() + conf_.drainTimeout + conf_.heartbeatInterval;
+        while (std::any_of(pids_.begin(), pids_.end(), [](pid_t pid) { return pid > 0; })) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            if (left.count() <= 0 && !killed) {
+                for (size_t i = 0; i < pids_.size(); ++i) {
+                    if (pids_[i] > 0) {
+                        LOG(WARN) << "Prefork worker " << i << " pid " << pids_[i] << " did not exit in time, killing";
+                        kill(pids_[i], SIGKILL);
+                    }
+                }
+                killed = true;
+                clean = false;
+                // 被杀死的进程由 zygote 立即回收，这里只为退出事件留出余量
+                deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+                continue;
+            }
+            if (left.count() <= 0) {
+                LOG(WARN) << "Prefork zygote " << zygote_ << " did not report all worker exits";
+                clean = false;
+                break;
+            }
+            pollfd fd{socket_, POLLIN, 0};
+            if (poll(&fd, 1, static_cast<int>(left.count())) <= 0) {
+                continue;
+            }
+            ZygoteEvent event{};
+            if (!receive(socket_, event)) {
+                LOG(WARN) << "Prefork zygote " << zygote_ << " exited before all workers";
+                clean = false;
+                break;
+            }
+            if (event.kind == ZygoteEvent::EXITED && event.index < pids_.size()) {
+                clean = exited(event.index, event.status, true) && clean;
+            }
+        }
+        close(socket_);
+        socket_ = -1;
+        waitpid(zygote_, nullptr, 0);
+        zygote_ = 0;
+        LOG(INFO) << "Prefork stopped, completed " << completed() << ", dropped " << dropped();
+        return clean;
+    }
+
+    // 删除任务通道的名字
+    void remove() const { channel_.remove(); }
+
+    [[nodiscard]] size_t workers() const { return conf_.workers; }
+    ShmTaskRing& ring() { return *channel_.get(); }
+
+    [[nodiscard]] uint64_t completed() const {
+        uint64_t total = 0;
+        for (size_t i = 0; i < conf_.workers; ++i) {
+            total += shared_.workers[i].completed.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    [[nodiscard]] uint64_t dropped() const {
+        uint64_t total = 0;
+        for (size_t i = 0; i < conf_.workers; ++i) {
+            total += shared_.workers[i].dropped.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    // 各工作进程的一行状态，-ping 时显示
+    [[nodiscard]] string describe() const {
+        string text = "prefork workers=" + std::to_string(conf_.workers) + " channel=" + channel_.name();
+        const int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+        for (size_t i = 0; i < conf_.workers; ++i) {
+            const CtrlWorker& worker = shared_.workers[i];
+            const int64_t age = (now - worker.heartbeatNs.load(std::memory_order_relaxed)) / 1000000;
+            text += "; [" + std::to_string(i) + "] pid=" + std::to_string(worker.pid.load(std::memory_order_relaxed))
+                    + " hb=" + std::to_string(age) + "ms"
+                    + " active=" + std::to_string(worker.active.load(std::memory_order_relaxed))
+                    + " queued=" + std::to_string(worker.queued.load(std::memory_order_relaxed))
+                    + " done=" + std::to_string(worker.completed.load(std::memory_order_relaxed))
+                    + " restarts=" + std::to_string(worker.restarts.load(std::memory_order_relaxed));
+        }
+        return text;
+    }
+
+private:
+    // zygote 报给主进程的事件，SOCK_SEQPACKET 下整条收发；主进程的派生请求只有槽位号
+    struct ZygoteEvent {
+        enum Kind : uint32_t { SPAWNED, SPAWN_FAILED, EXITED };
+        uint32_t kind;
+        uint32_t index;
+        int32_t pid;
+        int32_t status;             // EXITED 时为 waitpid 的状态，SPAWN_FAILED 时为 errno
+    };
+
+    static int64_t nowNs() {
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    // 本进程的线程数，按 /proc/self/task 下的条目计；无法读取时返回 0
+    static size_t threadCount() {
+        DIR* dir = opendir("/proc/self/task");
+        if (dir == nullptr) {
+            return 0;
+        }
+        size_t count = 0;
+        while (const dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                ++count;
+            }
+        }
+        closedir(dir);
+        return count;
+    }
+
+    // 对端关闭或出错时返回 false；MSG_NOSIGNAL 使对端已退出时不触发 SIGPIPE
+    template <typename T>
+    static bool send(int fd, const T& message) {
+        ssize_t n;
+        while ((n = ::send(fd, &message, sizeof(message), MSG_NOSIGNAL)) < 0 && errno == EINTR) {
+        }
+        return n == static_cast<ssize_t>(sizeof(message));
+    }
+
+    template <typename T>
+    static bool receive(int fd, T& message) {
+        ssize_t n;
+        while ((n = recv(fd, &message, sizeof(message), 0)) < 0 && errno == EINTR) {
+        }
+        return n == static_cast<ssize_t>(sizeof(message));
+    }
+
+    // zygote 主体：单线程，不写日志（日志线程一旦创建，之后的 fork 又会带上别的线程的锁）
+    // 按请求 fork 工作进程，SIGCHLD 经 signalfd 到达后立即回收，派生与退出都报给主进程
+    // 请求方向关闭（主进程 stop）后不再派生，工作进程全部退出后退出；主进程消失时直接退出
+    int runZygote() {
+        std::signal(SIGINT, SIG_IGN);
+        std::signal(SIGTERM, SIG_DFL);
+        sigset_t child;
+        sigset_t previous;
+        sigemptyset(&child);
+        sigaddset(&child, SIGCHLD);
+        sigprocmask(SIG_BLOCK, &child, &previous);
+        const int signal_fd = signalfd(-1, &child, SFD_NONBLOCK | SFD_CLOEXEC);
+        const auto interval = static_cast<int>(conf_.heartbeatInterval.count());
+
+        std::vector<pid_t> children(conf_.workers, 0);
+        size_t alive = 0;
+        bool accepting = true;
+        while (accepting || alive > 0) {
+            if (getppid() != master_pid_) {
+                return 1;
+            }
+            pollfd fds[2] = {{signal_fd, POLLIN, 0}, {socket_, POLLIN, 0}};
+            if (poll(fds, accepting ? 2 : 1, interval) < 0 && errno != EINTR) {
+                return 1;
+            }
+            if (accepting && (fds[1].revents & (POLLIN | POLLHUP))) {
+                uint32_t index = 0;
+                if (!receive(socket_, index)) {
+                    accepting = false;
+                } else if (index < children.size()) {
+                    const pid_t pid = fork();
+                    if (pid == 0) {
+                        close(socket_);
+                        close(signal_fd);
+                        sigprocmask(SIG_SETMASK, &previous, nullptr);
+                        _exit(runWorker(index));
+                    }
+                    if (pid > 0) {
+                        children[index] = pid;
+                        ++alive;
+                    }
+                    const ZygoteEvent event{pid > 0 ? ZygoteEvent::SPAWNED : ZygoteEvent::SPAWN_FAILED,
+                                            index, pid, pid > 0 ? 0 : errno};
+                    send(socket_, event);
+                }
+            }
+            signalfd_siginfo info;
+            while (signal_fd >= 0 && read(signal_fd, &info, sizeof(info)) == sizeof(info)) {
+            }
+            int status = 0;
+            pid_t pid;
+            while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+                const auto it = std::find(children.begin(), children.end(), pid);
+                if (it == children.end()) {
+                    continue;
+                }
+                *it = 0;
+                --alive;
+                const ZygoteEvent event{ZygoteEvent::EXITED, static_cast<uint32_t>(it - children.begin()), pid, status};
+                send(socket_, event);
+            }
+        }
+        return 0;
+    }
+
+    // 巡检：读 zygote 报来的退出事件，退出的槽位重启；心跳超时的先 SIGKILL，退出事件随后到达
+    void supervise() {
+        const auto interval = static_cast<int>(conf_.heartbeatInterval.count());
+        const auto timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(conf_.heartbeatTimeout).count();
+        while (!stopped_.load(std::memory_order_acquire) && !lost_) {
+            pollfd fd{socket_, POLLIN, 0};
+            if (poll(&fd, 1, interval) > 0) {
+                ZygoteEvent event{};
+                if (!receive(socket_, event)) {
+                    LOG(ERROR) << "Prefork zygote " << zygote_ << " exited, workers are no longer restarted";
+                    lost_ = true;
+                    return;
+                }
+                if (event.kind == ZygoteEvent::EXITED && event.index < pids_.size()) {
+                    exited(event.index, event.status, false);
+                }
+            }
+            for (size_t i = 0; i < pids_.size() && !stopped_.load(std::memory_order_acquire); ++i) {
+                if (pids_[i] == 0) {
+                    shared_.workers[i].restarts.fetch_add(1, std::memory_order_relaxed);
+                    spawn(i);
+                    continue;
+                }
+                const int64_t age = nowNs() - shared_.workers[i].heartbeatNs.load(std::memory_order_relaxed);
+                if (age > timeout) {
+                    LOG(ERROR) << "Prefork worker " << i << " pid " << pids_[i] << " missed heartbeat for "
+                               << age / 1000000 << " ms, killing";
+                    kill(pids_[i], SIGKILL);
+                    // 退出事件到达前不再重复杀
+                    shared_.workers[i].heartbeatNs.store(nowNs(), std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    // 记录一个工作进程的退出，非正常退出时写日志并返回 false；停止期间的正常退出不写日志
+    bool exited(size_t index, int status, bool stopping) {
+        CtrlWorker& worker = shared_.workers[index];
+        const bool clean = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        if (WIFSIGNALED(status)) {
+            LOG(ERROR) << "Prefork worker " << index << " pid " << pids_[index] << " killed by signal "
+                       << WTERMSIG(status) << ", " << worker.queued.load(std::memory_order_relaxed)
+                       << " taken tasks lost";
+        } else if (!stopping || !clean) {
+            LOG(ERROR) << "Prefork worker " << index << " pid " << pids_[index] << " exited with status "
+                       << WEXITSTATUS(status);
+        }
+        worker.state.store(CtrlWorker::EXITED, std::memory_order_release);
+        worker.pid.store(0, std::memory_order_release);
+        pids_[index] = 0;
+        return clean;
+    }
+
+    // 请 zygote 派生 index 槽位的工作进程并等待结果，等待期间到达的其他事件照常处理
+    bool spawn(size_t index) {
+        CtrlWorker& worker = shared_.workers[index];
+        worker.state.store(CtrlWorker::STARTING, std::memory_order_relaxed);
+        worker.heartbeatNs.store(nowNs(), std::memory_order_relaxed);
+        worker.active.store(0, std::memory_order_relaxed);
+        worker.queued.store(0, std::memory_order_relaxed);
+        if (!send(socket_, static_cast<uint32_t>(index))) {
+            LOG(ERROR) << "Prefork zygote " << zygote_ << " unreachable: " << strerror(errno);
+            worker.state.store(CtrlWorker::EXITED, std::memory_order_release);
+            lost_ = true;
+            return false;
+        }
+        while (true) {
+            ZygoteEvent event{};
+            if (!receive(socket_, event)) {
+                LOG(ERROR) << "Prefork zygote " << zygote_ << " exited while spawning worker " << index;
+                worker.state.store(CtrlWorker::EXITED, std::memory_order_release);
+                lost_ = true;
+                return false;
+            }
+            if (event.index >= pids_.size()) {
+                continue;
+            }
+            if (event.kind == ZygoteEvent::EXITED) {
+                exited(event.index, event.status, false);
+                continue;
+            }
+            if (event.index != index) {
+                continue;
+            }
+            if (event.kind == ZygoteEvent::SPAWN_FAILED) {
+                LOG(ERROR) << "Prefork worker " << index << " fork failed: " << strerror(event.status);
+                worker.state.store(CtrlWorker::EXITED, std::memory_order_release);
+                return false;
+            }
+            pids_[index] = event.pid;
+            worker.pid.store(static_cast<uint32_t>(event.pid), std::memory_order_release);
+            return true;
+        }
+    }
+
+    // 工作进程主体，在 fork 出的子进程中执行，返回值为退出码
+    // 取任务的线程在已取出的任务达到上限时等待其降到一半，否则从通道取，通道为空时睡在通道的 futex 上
+    // 两种等待都以 heartbeatInterval 为上限，醒来时写心跳与负载
+    int runWorker(size_t index) {
+        std::signal(SIGINT, SIG_IGN);
+        std::signal(SIGTERM, SIG_DFL);
+        SpdLogger::reopenAfterFork(".worker" + std::to_string(index));
+        if (worker_init_) {
+            worker_init_();
+        }
+
+        CtrlWorker& worker = shared_.workers[index];
+        ShmTaskRing& ring = *channel_.get();
+        const size_t limit = conf_.threadsPerWorker + conf_.prefetch;
+        // 降到一半以下才补充，补充一次取一批，取任务的线程不必每完成一个任务就被唤醒一次
+        const size_t low = limit / 2;
+        const auto handler = std::make_shared<ShmTaskConsumer::Handler>(handler_);
+
+        std::mutex mutex;
+        std::condition_variable room;
+        size_t inflight = 0;
+        const auto finish = [&]() {
+            bool wake;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                wake = --inflight == low;
+            }
+            if (wake) {
+                room.notify_one();
+            }
+        };
+
+        auto queue = make_shared<PriorityTaskQueue>();
+        queue->setExpiryCallback([&](Task&) {
+            worker.dropped.fetch_add(1, std::memory_order_relaxed);
+            finish();
+        });
+        ThreadPoolConfig pool_conf;
+        pool_conf.numThreads = conf_.threadsPerWorker;
+        pool_conf.latencyMetrics = false;
+        ThreadPool pool(pool_conf, queue, make_shared<TransCtx>());
+
+        worker.state.store(CtrlWorker::RUNNING, std::memory_order_release);
+        LOG(INFO) << "Prefork worker " << index << " running, pid " << getpid();
+        int32_t log_level = -1;
+        while (shared_.workerStop.load(std::memory_order_acquire) == 0) {
+            // zygote 随主进程退出，之后不再有人巡检与回收，按停止处理
+            if (getppid() != zygote_) {
+                LOG(WARN) << "Prefork worker " << index << " lost zygote " << zygote_ << ", stopping";
+                break;
+            }
+            worker.heartbeatNs.store(nowNs(), std::memory_order_relaxed);
+            if (const int32_t level = shared_.workerLogLevel.load(std::memory_order_relaxed);
+                level >= 0 && level != log_level) {
+                log_level = level;
+                SpdLogger::GetInstance()->setMinLevel(static_cast<LogLevel>(level));
+            }
+            worker.active.store(static_cast<uint32_t>(pool.getActiveThreads()), std::memory_order_relaxed);
+            size_t room_left;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                worker.queued.store(static_cast<uint32_t>(inflight), std::memory_order_relaxed);
+                if (inflight >= limit) {
+                    room.wait_for(lock, conf_.heartbeatInterval, [&]() { return inflight <= low; });
+                    continue;
+                }
+                room_left = limit - inflight;
+            }
+            size_t taken = 0;
+            uint32_t type = 0;
+            uint8_t priority = 0;
+            string payload;
+            // visit 中只复制记录，被杀死在槽位释放之前的窗口尽量短，入队放在释放之后
+            while (taken < room_left && ring.tryConsumeShared([&](const ShmRecordView& record) {
+                type = record.type;
+                priority = record.priority;
+                payload.assign(record.payload.data(), record.payload.size());
+            })) {
+                ++taken;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++inflight;
+                }
+                Task task([&worker, &finish, handler, type, payload = std::move(payload)]
+                          (const shared_ptr<TransCtx>& ctx) {
+                    (*handler)(type, payload, ctx);
+                    worker.completed.fetch_add(1, std::memory_order_relaxed);
+                    finish();
+                }, shmRecordPriority(priority));
+                if (!queue->push(std::move(task))) {
+                    worker.dropped.fetch_add(1, std::memory_order_relaxed);
+                    finish();
+                }
+            }
+            if (taken == 0) {
+                ring.waitForData(conf_.heartbeatInterval);
+            }
+        }
+
+        worker.state.store(CtrlWorker::STOPPING, std::memory_order_release);
+        const bool drained = pool.drain(conf_.drainTimeout);
+        pool.stop();
+        LOG(INFO) << "Prefork worker " << index << " stopping, " << (drained ? "drained" : "drain timed out");
+        worker.queued.store(0, std::memory_order_relaxed);
+        worker.active.store(0, std::memory_order_relaxed);
+        worker.state.store(CtrlWorker::EXITED, std::memory_order_release);
+        SpdLogger::GetInstance()->flush();
+        return drained ? 0 : 1;
+    }
+
+    PreforkConfig conf_;
+    CtrlShared& shared_;
+    ShmTaskConsumer::Handler handler_;
+    std::function<void()> worker_init_;
+    CreateShare<ShmTaskRing> channel_;
+    const pid_t master_pid_;
+    pid_t zygote_ = 0;          // 主进程中为 zygote 的 pid，zygote 中为自身 pid，工作进程据此判断父进程是否还在
+    int socket_ = -1;           // 主进程与 zygote 各持一端：主进程发派生请求，zygote 回派生与退出事件
+    bool lost_ = false;         // zygote 已退出，不再重启工作进程
+    std::vector<pid_t> pids_;
+    std::thread supervisor_;
+    std::atomic<bool> stopped_{true};
+};
+
+#endif //FRAME_PREFORK_H
@@ -0,0 +1,170 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_RINGBUFFER_H
+#define FRAME_RINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+using namespace std;
+
+// 忙等时让出流水线
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+inline size_t roundUpPow2(size_t n) {
+    size_t cap = 1;
+    while (cap < n) {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+// 有界多生产者多消费者无锁环形队列（基于每个槽位的序号）
+// 槽位序号 == 位置 表示可写，== 位置+1 表示可读
+template <typename T>
+class MpmcRing {
+public:
+    explicit MpmcRing(size_t capacity)
+        : mask_(roundUpPow2(capacity < 2 ? 2 : capacity) - 1)
+        , cells_(new Cell[mask_ + 1])
+        , head_(0)
+        , tail_(0) {
+        for (size_t i = 0; i <= mask_; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcRing(const MpmcRing &) = delete;
+    void operator=(const MpmcRing &) = delete;
+
+    // 满时返回 false
+    template <typename U>
+    bool tryPush(U&& value) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[pos & mask_];
+            const size_t seq = cell->seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::forward<U>(value);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 空时返回 false
+    bool tryPop(T& out) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[pos & mask_];
+            const size_t seq = cell->seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        out = std::move(cell->data);
+        cell->data = T();
+        cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 近似值，仅用于判断是否可能非空
+    [[nodiscard]] bool empty() const {
+        return head_.load(std::memory_order_acquire) >= tail_.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+};
+
+// 单线程使用的可增长环形 FIFO，只扩容不缩容
+// 稳态下入队出队都不分配内存（std::deque 每隔几个元素就会申请/释放一个节点）
+template <typename T>
+class FifoBuffer {
+public:
+    explicit FifoBuffer(size_t capacity = 16)
+        : slots_(new T[roundUpPow2(capacity < 2 ? 2 : capacity)])
+        , mask_(roundUpPow2(capacity < 2 ? 2 : capacity) - 1)
+        , head_(0)
+        , size_(0) {}
+
+    FifoBuffer(FifoBuffer&&) noexcept = default;
+    FifoBuffer& operator=(FifoBuffer&&) noexcept = default;
+
+    void push_back(T&& value) {
+        if (size_ > mask_) {
+            grow();
+        }
+        slots_[(head_ + size_) & mask_] = std::move(value);
+        ++size_;
+    }
+
+    T& front() { return slots_[head_]; }
+    const T& front() const { return slots_[head_]; }
+
+    void pop_front() {
+        slots_[head_] = T();
+        head_ = (head_ + 1) & mask_;
+        --size_;
+    }
+
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+
+private:
+    void grow() {
+        const size_t capacity = (mask_ + 1) * 2;
+        std::unique_ptr<T[]> slots(new T[capacity]);
+        for (size_t i = 0; i < size_; ++i) {
+            slots[i] = std::move(slots_[(head_ + i) & mask_]);
+        }
+        slots_ = std::move(slots);
+        mask_ = capacity - 1;
+        head_ = 0;
+    }
+
+    std::unique_ptr<T[]> slots_;
+    size_t mask_;
+    size_t head_;
+    size_t size_;
+};
+
+#endif //FRAME_RINGBUFFER_H
@@ -0,0 +1,109 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_SEQLOCK_H
+#define FRAME_SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "RingBuffer.h"
+
+using namespace std;
+
+// 顺序锁：读者不加锁、不写共享内存，读到写入中途的数据时重试，总是得到一次完整写入的值
+// 写者通过 CAS 把序号从偶数改为奇数取得写权，多个写者（包括不同进程）之间互斥
+// 数据按 8 字节原子字逐字复制，读写并发时没有数据竞争；全零为合法初值，可直接放在新建的共享内存中
+// 适合读多写少、T 不大的场景，写者在写入期间被杀死时读者会一直重试
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock requires a trivially copyable type");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "SeqLock requires lock-free 64-bit atomics");
+
+public:
+    SeqLock() = default;
+    explicit SeqLock(const T& value) { store(value); }
+
+    SeqLock(const SeqLock &) = delete;
+    void operator=(const SeqLock &) = delete;
+
+    [[nodiscard]] T load() const {
+        uint64_t words[kWords];
+        while (true) {
+            const uint32_t before = seq_.load(std::memory_order_acquire);
+            if (before & 1) {
+                cpuRelax();
+                continue;
+            }
+            for (size_t i = 0; i < kWords; ++i) {
+                words[i] = words_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+    void store(const T& value) {
+        uint64_t words[kWords] = {};
+        std::memcpy(words, &value, sizeof(T));
+        const uint32_t seq = lock();
+        for (size_t i = 0; i < kWords; ++i) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // 在写权内读改写，update 接收当前值的副本并就地修改
+    template <typename F>
+    void update(F&& update) {
+        uint64_t words[kWords];
+        const uint32_t seq = lock();
+        for (size_t i = 0; i < kWords; ++i) {
+            words[i] = words_[i].load(std::memory_order_relaxed);
+        }
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        update(value);
+        std::memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < kWords; ++i) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // 每次写入加 2，可用于判断值是否变化
+    [[nodiscard]] uint32_t version() const {
+        return seq_.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    // 返回取得写权前的偶数序号
+    uint32_t lock() {
+        uint32_t seq = seq_.load(std::memory_order_relaxed);
+        while (true) {
+            if ((seq & 1) == 0
+                && seq_.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                break;
+            }
+            cpuRelax();
+            seq = seq_.load(std::memory_order_relaxed);
+        }
+        // 序号变为奇数后才写数据
+        std::atomic_thread_fence(std::memory_order_release);
+        return seq;
+    }
+
+    std::atomic<uint32_t> seq_{0};
+    std::atomic<uint64_t> words_[kWords]{};
+};
+
+#endif //FRAME_SEQLOCK_H
@@ -0,0 +1,187 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_SHMRING_H
+#define FRAME_SHMRING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <climits>
+#include "Futex.h"
+#include "RingBuffer.h"
+
+using namespace std;
+
+// 出队时看到的一条记录，payload 指向槽位，回调返回后失效
+struct ShmRecordView {
+    uint32_t type;
+    uint8_t priority;
+    int64_t sendNs;             // 生产者写入时的 steady_clock，同一主机上各进程可比
+    std::string_view payload;
+};
+
+// 共享内存中的有界多生产者单消费者环，定长槽位，槽位序号协议同 MpmcRing
+// 整个对象放在共享段中，只能由创建者构造一次（CreateShare 的 POSIX 后端）
+// 生产者之间以 CAS 抢占位置；消费者默认唯一，不需要 CAS，多个消费者时改用 tryConsumeShared
+// 消费者睡在共享的 futex 字上，生产者只有在确实有人睡眠时才发起唤醒系统调用
+// 生产者在写槽位期间被杀死时，该槽位永远不会就绪，消费者会停在这里
+template <size_t SlotSize, size_t Capacity>
+class ShmRing {
+    static_assert((Capacity & (Capacity - 1)) == 0 && Capacity >= 2, "Capacity must be a power of two");
+    static_assert(SlotSize >= 64 && SlotSize % 64 == 0, "SlotSize must be a multiple of 64");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+                  "ShmRing requires lock-free atomics");
+
+public:
+    ShmRing() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ShmRing(const ShmRing &) = delete;
+    void operator=(const ShmRing &) = delete;
+
+    // 每条记录的最大负载字节数
+    static constexpr size_t maxPayload() { return sizeof(Slot::payload); }
+    static constexpr size_t capacity() { return Capacity; }
+
+    // 满或负载过大时返回 false
+    bool tryPush(uint32_t type, uint8_t priority, const void* data, size_t size) {
+        if (size > maxPayload()) {
+            oversized_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        uint64_t pos = tail_.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots_[pos & (Capacity - 1)];
+            const uint64_t seq = slot->seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                full_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->type = type;
+        slot->priority = priority;
+        slot->size = static_cast<uint32_t>(size);
+        slot->sendNs = std::chrono::steady_clock::now().time_since_epoch().count();
+        std::memcpy(slot->payload, data, size);
+        slot->seq.store(pos + 1, std::memory_order_release);
+
+        // 与消费者登记睡眠后的重新检查配对：要么消费者看到本条记录，要么这里看到睡眠者
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) > 0) {
+            wake_.fetch_add(1, std::memory_order_release);
+            futexWake(wake_, 1);
+        }
+        return true;
+    }
+
+    // 仅消费者调用：有记录时以 visit 处理并释放槽位，返回 true
+    template <typename Visitor>
+    bool tryConsume(Visitor&& visit) {
+        const uint64_t pos = head_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[pos & (Capacity - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        visit(ShmRecordView{slot.type, slot.priority, slot.sendNs,
+                            std::string_view(slot.payload, slot.size)});
+        head_.store(pos + 1, std::memory_order_relaxed);
+        slot.seq.store(pos + Capacity, std::memory_order_release);
+        return true;
+    }
+
+    // 多个消费者（如预派生的各工作进程共同消费一个环）时使用：以 CAS 抢占位置，抢到后处理并释放槽位
+    // 不能与 tryConsume 混用；消费者在 visit 期间被杀死时该槽位不再释放：其他消费者越过它继续取后面的记录，
+    // 但生产者绕回到这里时一直看到环满，此后所有生产者都写不进去，只能删除环重建；visit 中只复制记录，不做耗时的事
+    template <typename Visitor>
+    bool tryConsumeShared(Visitor&& visit) {
+        uint64_t pos = head_.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots_[pos & (Capacity - 1)];
+            const uint64_t seq = slot->seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        visit(ShmRecordView{slot->type, slot->priority, slot->sendNs,
+                            std::string_view(slot->payload, slot->size)});
+        slot->seq.store(pos + Capacity, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者调用：环为空时睡眠，直到有记录、被 wakeConsumer 唤醒或超时
+    void waitForData(std::chrono::milliseconds timeout) {
+        const uint32_t epoch = wake_.load(std::memory_order_acquire);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ready()) {
+            futexWait(wake_, epoch, timeout);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // 让睡眠中的消费者返回，用于停止
+    void wakeConsumer() {
+        wake_.fetch_add(1, std::memory_order_release);
+        futexWake(wake_, INT_MAX);
+    }
+
+    // 近似值
+    [[nodiscard]] size_t size() const {
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        const uint64_t tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? static_cast<size_t>(tail - head) : 0;
+    }
+
+    // 生产者因满而失败的次数
+    [[nodiscard]] uint64_t fullCount() const { return full_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t oversizedCount() const { return oversized_.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> seq;
+        int64_t sendNs;
+        uint32_t type;
+        uint32_t size;
+        uint8_t priority;
+        char payload[SlotSize - 25];
+    };
+    static_assert(sizeof(Slot) == SlotSize, "unexpected slot padding");
+
+    [[nodiscard]] bool ready() const {
+        const uint64_t pos = head_.load(std::memory_order_relaxed);
+        return slots_[pos & (Capacity - 1)].seq.load(std::memory_order_acquire) == pos + 1;
+    }
+
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    alignas(64) std::atomic<uint32_t> wake_{0};
+    std::atomic<uint32_t> sleepers_{0};
+    alignas(64) std::atomic<uint64_t> full_{0};
+    std::atomic<uint64_t> oversized_{0};
+    Slot slots_[Capacity];
+};
+
+#endif //FRAME_SHMRING_H
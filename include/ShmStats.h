@@ -0,0 +1,259 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_SHMSTATS_H
+#define FRAME_SHMSTATS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+using namespace std;
+
+// 运行时统计：各组件把计数与瞬时值写入统计段，外部进程只读映射后汇总显示
+// 每个写者占一个缓存行大小的槽位，发布只是一次 relaxed store，写者之间不共享缓存行
+// 同名槽位由读者汇总：计数求和并计算速率，瞬时值求和（如各工作线程的忙闲、各队列的深度）
+// 槽位记下登记它的进程；进程被杀或崩溃时来不及释放，读者跳过这些槽位，登记时回收它们
+enum class StatKind : uint8_t {
+    COUNTER = 1,    // 只增的累计值
+    GAUGE = 2       // 当前值
+};
+
+struct alignas(64) StatSlot {
+    enum : uint32_t { EMPTY = 0, CLAIMING = 1, ACTIVE = 2, RELEASED = 3 };
+    static constexpr size_t kNameSize = 47;
+
+    std::atomic<uint64_t> value{0};
+    std::atomic<uint32_t> state{EMPTY};
+    std::atomic<uint32_t> pid{0};   // 登记者的进程号，CLAIMING 之后、ACTIVE 之前写入
+    StatKind kind = StatKind::COUNTER;
+    char name[kNameSize] = {};
+};
+static_assert(sizeof(StatSlot) == 64, "StatSlot must fill exactly one cache line");
+
+// 统计段，放在 CreateShare 的 POSIX 段中；槽位只追加，释放后或登记者退出后可被重新登记
+struct StatsSegment {
+    static constexpr size_t kSlots = 1024;
+
+    std::atomic<uint32_t> ownerPid{0};
+    std::atomic<uint32_t> used{0};
+    StatSlot slots[kSlots];
+};
+
+// 一个槽位的写入句柄，析构时释放槽位
+// add 为单写者的累加（load + store），多个线程共用一个句柄时用 fetchAdd
+class StatCell {
+public:
+    StatCell() : slot_(&spare()) {}
+    ~StatCell() { release(); }
+
+    StatCell(StatCell&& other) noexcept : slot_(other.slot_) { other.slot_ = &spare(); }
+    StatCell& operator=(StatCell&& other) noexcept {
+        if (this != &other) {
+            release();
+            slot_ = other.slot_;
+            other.slot_ = &spare();
+        }
+        return *this;
+    }
+
+    StatCell(const StatCell &) = delete;
+    void operator=(const StatCell &) = delete;
+
+    void set(uint64_t value) const {
+        slot_->value.store(value, std::memory_order_relaxed);
+    }
+
+    void add(uint64_t delta = 1) const {
+        slot_->value.store(slot_->value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    void fetchAdd(uint64_t delta = 1) const {
+        slot_->value.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    void fetchSub(uint64_t delta = 1) const {
+        slot_->value.fetch_sub(delta, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t value() const {
+        return slot_->value.load(std::memory_order_relaxed);
+    }
+
+    // 是否登记到了真实槽位，段满时写入被丢弃
+    [[nodiscard]] bool bound() const { return slot_ != &spare(); }
+
+private:
+    friend class ShmStats;
+
+    explicit StatCell(StatSlot* slot) : slot_(slot) {}
+
+    void release() {
+        if (bound()) {
+            slot_->state.store(StatSlot::RELEASED, std::memory_order_release);
+            slot_ = &spare();
+        }
+    }
+
+    // 段满时的落点，不属于任何段，读者看不到
+    static StatSlot& spare() {
+        static StatSlot slot;
+        return slot;
+    }
+
+    StatSlot* slot_;
+};
+
+// 读者看到的一项汇总
+struct StatSample {
+    StatKind kind;
+    uint64_t value;
+    size_t writers;         // 同名槽位数
+};
+
+// 登记入口：未安装共享段时写入进程内的段，统计照常工作但外部不可见
+// install 应在创建线程池等组件之前调用，之前登记的槽位不会迁移；
+// 先于 install 创建的长寿组件（如日志写线程）可比较 generation() 后重新登记
+class ShmStats {
+public:
+    static StatCell counter(std::string_view name) {
+        return claim(name, StatKind::COUNTER);
+    }
+
+    static StatCell gauge(std::string_view name) {
+        return claim(name, StatKind::GAUGE);
+    }
+
+    // segment 须在进程退出前一直有效
+    static void install(StatsSegment* segment) {
+        current().store(segment, std::memory_order_release);
+        generationCounter().fetch_add(1, std::memory_order_release);
+    }
+
+    // 每次 install 加 1
+    static uint64_t generation() {
+        return generationCounter().load(std::memory_order_acquire);
+    }
+
+    static StatsSegment* segment() {
+        return current().load(std::memory_order_acquire);
+    }
+
+    // 按名字汇总当前登记的槽位；与写者并发时名字可能在登记途中，前后两次状态不一致的槽位跳过
+    // 登记者已退出（被杀、崩溃）而未释放的槽位跳过，不把它们最后的瞬时值算进来
+    static std::map<string, StatSample> collect(const StatsSegment& segment) {
+        std::map<string, StatSample> out;
+        std::map<uint32_t, bool> alive;
+        const auto owner_alive = [&alive](uint32_t pid) {
+            const auto [it, inserted] = alive.try_emplace(pid, false);
+            if (inserted) {
+                it->second = processAlive(pid);
+            }
+            return it->second;
+        };
+        const size_t used = std::min<size_t>(segment.used.load(std::memory_order_acquire), StatsSegment::kSlots);
+        for (size_t i = 0; i < used; ++i) {
+            const StatSlot& slot = segment.slots[i];
+            if (slot.state.load(std::memory_order_acquire) != StatSlot::ACTIVE) {
+                continue;
+            }
+            if (!owner_alive(slot.pid.load(std::memory_order_relaxed))) {
+                continue;
+            }
+            char name[StatSlot::kNameSize];
+            std::memcpy(name, slot.name, sizeof(name));
+            name[sizeof(name) - 1] = '\0';
+            const StatKind kind = slot.kind;
+            const uint64_t value = slot.value.load(std::memory_order_relaxed);
+            if (slot.state.load(std::memory_order_acquire) != StatSlot::ACTIVE) {
+                continue;
+            }
+            auto [it, inserted] = out.try_emplace(name, StatSample{kind, 0, 0});
+            it->second.value += value;
+            ++it->second.writers;
+        }
+        return out;
+    }
+
+private:
+    static std::atomic<uint64_t>& generationCounter() {
+        static std::atomic<uint64_t> generation{0};
+        return generation;
+    }
+
+    static std::atomic<StatsSegment*>& current() {
+        static StatsSegment local;
+        static std::atomic<StatsSegment*> segment{&local};
+        return segment;
+    }
+
+    // pid 为 0 的槽位来自未记录进程号的写者，按存活处理
+    static bool processAlive(uint32_t pid) {
+        return pid == 0 || kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+    }
+
+    static StatCell claim(std::string_view name, StatKind kind) {
+        StatsSegment* segment = ShmStats::segment();
+        StatSlot* slot = nullptr;
+        const auto self = static_cast<uint32_t>(getpid());
+        // 先复用已释放的槽位，避免反复创建销毁的组件耗尽统计段
+        const size_t used = std::min<size_t>(segment->used.load(std::memory_order_acquire), StatsSegment::kSlots);
+        for (size_t i = 0; i < used && slot == nullptr; ++i) {
+            uint32_t expected = StatSlot::RELEASED;
+            if (segment->slots[i].state.compare_exchange_strong(expected, StatSlot::CLAIMING,
+                                                                std::memory_order_acquire)) {
+                slot = &segment->slots[i];
+            }
+        }
+        // 再回收已退出进程留下的 ACTIVE 槽位（如被 SIGKILL 的预派生工作进程），重启循环不会耗尽统计段
+        // CLAIMING 中的槽位 pid 可能还是上一个登记者的，不回收
+        uint32_t dead = 0;
+        for (size_t i = 0; i < used && slot == nullptr; ++i) {
+            StatSlot& candidate = segment->slots[i];
+            if (candidate.state.load(std::memory_order_acquire) != StatSlot::ACTIVE) {
+                continue;
+            }
+            const uint32_t owner = candidate.pid.load(std::memory_order_relaxed);
+            if (owner == self || (owner != dead && processAlive(owner))) {
+                continue;
+            }
+            dead = owner;
+            uint32_t expected = StatSlot::ACTIVE;
+            if (!candidate.state.compare_exchange_strong(expected, StatSlot::CLAIMING, std::memory_order_acquire)) {
+                continue;
+            }
+            if (candidate.pid.load(std::memory_order_relaxed) != owner) {
+                // 读取 pid 之后槽位已被别的进程回收并重新登记，还给它
+                candidate.state.store(StatSlot::ACTIVE, std::memory_order_release);
+                continue;
+            }
+            slot = &candidate;
+        }
+        if (slot == nullptr) {
+            const size_t index = segment->used.fetch_add(1, std::memory_order_acq_rel);
+            if (index >= StatsSegment::kSlots) {
+                return {};
+            }
+            slot = &segment->slots[index];
+            slot->state.store(StatSlot::CLAIMING, std::memory_order_relaxed);
+        }
+        const size_t length = std::min(name.size(), StatSlot::kNameSize - 1);
+        std::memcpy(slot->name, name.data(), length);
+        std::memset(slot->name + length, 0, StatSlot::kNameSize - length);
+        slot->pid.store(self, std::memory_order_relaxed);
+        slot->kind = kind;
+        slot->value.store(0, std::memory_order_relaxed);
+        slot->state.store(StatSlot::ACTIVE, std::memory_order_release);
+        return StatCell(slot);
+    }
+};
+
+#endif //FRAME_SHMSTATS_H
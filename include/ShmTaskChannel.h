@@ -0,0 +1,196 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_SHMTASKCHANNEL_H
+#define FRAME_SHMTASKCHANNEL_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "CreateShare.h"
+#include "Logger.h"
+#include "ShmRing.h"
+#include "TaskQueue.h"
+
+using namespace std;
+
+// 跨进程任务通道：其他进程把 (类型, 优先级, 负载) 写入共享内存环，
+// 本进程的消费线程取出记录，转成任务按原优先级推入 PriorityTaskQueue
+// 每条记录占一个 256 字节槽位，负载最多 231 字节，更大的数据应放在别处只传引用
+using ShmTaskRing = ShmRing<256, 4096>;
+
+// 通道的共享段总是使用 POSIX 后端，由第一个打开者构造环
+inline ShareOptions shmChannelOptions(bool huge_pages = false) {
+    ShareOptions options;
+    options.backend = ShareBackend::POSIX;
+    options.hugePages = huge_pages;
+    options.size = sizeof(ShmTaskRing);
+    return options;
+}
+
+// 请求了大页但段落在普通页上时提示一次，CreateShare 自身不写这条日志
+inline void warnHugePageFallback(const CreateShare<ShmTaskRing>& share, bool huge_pages) {
+    if (huge_pages && share.valid() && !share.hugePages()) {
+        LOG(WARN) << "Huge pages unavailable, using normal pages for " << share.name();
+    }
+}
+
+// 记录中的优先级，越界时按 NORMAL
+inline Priority shmRecordPriority(uint8_t value) {
+    if (value < static_cast<uint8_t>(Priority::LOW) || value > static_cast<uint8_t>(Priority::CRITICAL)) {
+        return Priority::NORMAL;
+    }
+    return static_cast<Priority>(value);
+}
+
+// 生产者端，可在任意进程、任意线程使用
+class ShmTaskProducer {
+public:
+    explicit ShmTaskProducer(int channel_id, string share_path = "/tmp", bool huge_pages = false) :
+        share_(channel_id, OWN_RW_OTH_RW, std::move(share_path), shmChannelOptions(huge_pages)) {
+        warnHugePageFallback(share_, huge_pages);
+    }
+
+    // 环满或负载过大时返回 false，由调用方决定重试或丢弃
+    bool submit(uint32_t type, Priority priority, std::string_view payload) {
+        return share_.get()->tryPush(type, static_cast<uint8_t>(priority), payload.data(), payload.size());
+    }
+
+    [[nodiscard]] bool valid() const { return share_.valid(); }
+    ShmTaskRing& ring() { return *share_.get(); }
+
+private:
+    CreateShare<ShmTaskRing> share_;
+};
+
+// 消费者端，每个通道只能有一个
+// 队列拒绝时记录留在本地重试，不再从环中取新记录，生产者随后看到环满，形成反压
+class ShmTaskConsumer {
+public:
+    // 在工作线程中执行，payload 为记录负载的副本
+    using Handler = std::function<void(uint32_t type, std::string_view payload, const shared_ptr<TransCtx>& ctx)>;
+
+    ShmTaskConsumer(int channel_id, shared_ptr<PriorityTaskQueue> queue, Handler handler,
+                    string share_path = "/tmp", bool huge_pages = false) :
+        share_(channel_id, OWN_RW_OTH_RW, std::move(share_path), shmChannelOptions(huge_pages)),
+        queue_(std::move(queue)),
+        handler_(std::make_shared<Handler>(std::move(handler))) {
+        warnHugePageFallback(share_, huge_pages);
+    }
+
+    ~ShmTaskConsumer() {
+        stop();
+    }
+
+    ShmTaskConsumer(const ShmTaskConsumer &) = delete;
+    void operator=(const ShmTaskConsumer &) = delete;
+
+    void start() {
+        if (thread_.joinable()) {
+            return;
+        }
+        stopped_.store(false, std::memory_order_relaxed);
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    // 停止后环中剩余的记录保留在共享内存中，下一个消费者可以继续取；已取出的记录先推入队列再返回
+    void stop() {
+        stopped_.store(true, std::memory_order_relaxed);
+        share_.get()->wakeConsumer();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    // 删除共享段的名字，已打开的生产者不受影响
+    void remove() const { share_.remove(); }
+
+    [[nodiscard]] bool valid() const { return share_.valid(); }
+    ShmTaskRing& ring() { return *share_.get(); }
+    // 已推入队列的记录数
+    [[nodiscard]] uint64_t received() const { return received_.load(std::memory_order_relaxed); }
+    // 队列拒绝后重试的次数
+    [[nodiscard]] uint64_t deferred() const { return deferred_.load(std::memory_order_relaxed); }
+    // 停止时已从环中取出、仍未能推入队列而丢弃的记录数
+    [[nodiscard]] uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kBatchSize = 64;
+    static constexpr std::chrono::milliseconds kIdleWait{100};
+    static constexpr std::chrono::milliseconds kRetryWait{1};
+    static constexpr std::chrono::milliseconds kStopFlush{1000};
+
+    void run() {
+        ShmTaskRing& ring = *share_.get();
+        std::vector<Task> batch;
+        std::vector<Task> pending;
+        batch.reserve(kBatchSize);
+        while (!stopped_.load(std::memory_order_relaxed)) {
+            if (!pending.empty()) {
+                batch.swap(pending);
+                pending.clear();
+                received_.fetch_add(queue_->pushBatch(batch, &pending).accepted, std::memory_order_relaxed);
+                batch.clear();
+                if (!pending.empty()) {
+                    deferred_.fetch_add(1, std::memory_order_relaxed);
+                    std::this_thread::sleep_for(kRetryWait);
+                    continue;
+                }
+            }
+
+            while (batch.size() < kBatchSize && ring.tryConsume([&](const ShmRecordView& record) {
+                batch.emplace_back([handler = handler_, type = record.type, payload = string(record.payload)]
+                                   (const shared_ptr<TransCtx>& ctx) {
+                    (*handler)(type, payload, ctx);
+                }, shmRecordPriority(record.priority));
+            })) {}
+
+            if (batch.empty()) {
+                ring.waitForData(kIdleWait);
+                continue;
+            }
+            received_.fetch_add(queue_->pushBatch(batch, &pending).accepted, std::memory_order_relaxed);
+            batch.clear();
+            if (!pending.empty()) {
+                LOG_PER_SECOND(WARN, 1) << "Shm channel " << share_.name() << " deferred "
+                                        << pending.size() << " tasks, queue is full";
+            }
+        }
+
+        // 被拒绝的记录已离开共享内存环，停止时再推几次，仍被拒绝的计入 dropped()
+        // 应在关闭队列准入之前停止消费者
+        const auto deadline = std::chrono::steady_clock::now() + kStopFlush;
+        while (!pending.empty()) {
+            batch.swap(pending);
+            pending.clear();
+            received_.fetch_add(queue_->pushBatch(batch, &pending).accepted, std::memory_order_relaxed);
+            batch.clear();
+            if (pending.empty() || std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+            std::this_thread::sleep_for(kRetryWait);
+        }
+        if (!pending.empty()) {
+            dropped_.fetch_add(pending.size(), std::memory_order_relaxed);
+            LOG(WARN) << "Shm channel " << share_.name() << " dropped " << pending.size()
+                      << " taken tasks on stop, queue is full or closed";
+        }
+    }
+
+    CreateShare<ShmTaskRing> share_;
+    shared_ptr<PriorityTaskQueue> queue_;
+    shared_ptr<Handler> handler_;
+    std::atomic<bool> stopped_{true};
+    std::atomic<uint64_t> received_{0};
+    std::atomic<uint64_t> deferred_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::thread thread_;
+};
+
+#endif //FRAME_SHMTASKCHANNEL_H
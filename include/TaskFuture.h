@@ -0,0 +1,265 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_TASKFUTURE_H
+#define FRAME_TASKFUTURE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "TaskQueue.h"
+
+using namespace std;
+
+class ThreadPool;
+
+// 在 ThreadPool.h 中定义，续体以 QUEUED 方式运行时用它重新入队
+bool submitToPool(ThreadPool* pool, Task&& task);
+
+// 续体运行方式
+enum class ContinuationMode {
+    INLINE,   // 在完成前一个任务的线程上直接运行（已完成时在调用 then 的线程上运行）
+    QUEUED    // 作为新任务重新提交到线程池
+};
+
+// void 结果的占位类型
+struct FutureUnit {};
+
+template <typename T>
+using FutureValue = std::conditional_t<std::is_void_v<T>, FutureUnit, T>;
+
+// future 与 promise 共享的状态
+template <typename T>
+class FutureState {
+public:
+    using Value = FutureValue<T>;
+    using Callback = InlineFunction<void(), 64>;
+
+    explicit FutureState(ThreadPool* pool = nullptr) : pool_(pool), ready_(false) {}
+
+    FutureState(const FutureState &) = delete;
+    void operator=(const FutureState &) = delete;
+
+    // 只有第一次设置生效
+    void setValue(Value value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (ready_) {
+            return;
+        }
+        value_.emplace(std::move(value));
+        complete(lock);
+    }
+
+    void setError(std::exception_ptr error) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (ready_) {
+            return;
+        }
+        error_ = std::move(error);
+        complete(lock);
+    }
+
+    // 完成时回调；已完成则立即在当前线程调用
+    void onReady(Callback callback) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!ready_) {
+            callbacks_.push_back(std::move(callback));
+            return;
+        }
+        lock.unlock();
+        callback();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return ready_; });
+    }
+
+    bool waitFor(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, timeout, [this] { return ready_; });
+    }
+
+    bool ready() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return ready_;
+    }
+
+    // 以下在 ready 之后调用
+    Value& value() { return *value_; }
+    const std::exception_ptr& error() const { return error_; }
+    ThreadPool* pool() const { return pool_; }
+
+private:
+    void complete(std::unique_lock<std::mutex>& lock) {
+        ready_ = true;
+        std::vector<Callback> callbacks;
+        callbacks.swap(callbacks_);
+        lock.unlock();
+        cv_.notify_all();
+        for (auto& callback : callbacks) {
+            callback();
+        }
+    }
+
+    ThreadPool* pool_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool ready_;
+    std::optional<Value> value_;
+    std::exception_ptr error_;
+    std::vector<Callback> callbacks_;
+};
+
+// 写端，只可移动；未设置结果就被销毁时（任务被拒绝、超时丢弃或线程池已停止）以异常完成
+template <typename T>
+class TaskPromise {
+public:
+    using Value = FutureValue<T>;
+
+    TaskPromise() = default;
+    explicit TaskPromise(std::shared_ptr<FutureState<T>> state) : state_(std::move(state)) {}
+
+    TaskPromise(TaskPromise&&) noexcept = default;
+    TaskPromise& operator=(TaskPromise&& other) noexcept {
+        if (this != &other) {
+            abandon();
+            state_ = std::move(other.state_);
+        }
+        return *this;
+    }
+
+    TaskPromise(const TaskPromise &) = delete;
+    TaskPromise& operator=(const TaskPromise &) = delete;
+
+    ~TaskPromise() {
+        abandon();
+    }
+
+    void setValue(Value value = Value()) {
+        if (state_) {
+            state_->setValue(std::move(value));
+            state_.reset();
+        }
+    }
+
+    void setError(std::exception_ptr error) {
+        if (state_) {
+            state_->setError(std::move(error));
+            state_.reset();
+        }
+    }
+
+private:
+    void abandon() {
+        if (state_) {
+            setError(std::make_exception_ptr(
+                std::runtime_error("task dropped before completion")));
+        }
+    }
+
+    std::shared_ptr<FutureState<T>> state_;
+};
+
+// 调用 fn 并把返回值或异常写入 promise
+template <typename R, typename Fn, typename... Args>
+void fulfil(TaskPromise<R>& promise, Fn& fn, Args&&... args) {
+    try {
+        if constexpr (std::is_void_v<R>) {
+            fn(std::forward<Args>(args)...);
+            promise.setValue();
+        } else {
+            promise.setValue(fn(std::forward<Args>(args)...));
+        }
+    } catch (...) {
+        promise.setError(std::current_exception());
+    }
+}
+
+// then 的结果类型：前一个结果为 void 时续体无参数，否则以结果的引用调用
+template <typename T, typename Fn>
+struct ContinuationResult {
+    using type = std::invoke_result_t<Fn&, FutureValue<T>&>;
+};
+
+template <typename Fn>
+struct ContinuationResult<void, Fn> {
+    using type = std::invoke_result_t<Fn&>;
+};
+
+template <typename T>
+class TaskFuture {
+public:
+    TaskFuture() = default;
+    explicit TaskFuture(std::shared_ptr<FutureState<T>> state) : state_(std::move(state)) {}
+
+    [[nodiscard]] bool valid() const { return state_ != nullptr; }
+
+    bool ready() const { return state_->ready(); }
+
+    void wait() const { state_->wait(); }
+
+    bool waitFor(std::chrono::milliseconds timeout) const { return state_->waitFor(timeout); }
+
+    // 阻塞等待结果，任务异常在此重新抛出
+    // 不要在工作线程中对同一线程池的任务调用，应改用 then
+    T get() const {
+        state_->wait();
+        if (state_->error()) {
+            std::rethrow_exception(state_->error());
+        }
+        if constexpr (!std::is_void_v<T>) {
+            return state_->value();
+        }
+    }
+
+    // 注册续体，返回续体结果的 future
+    // 前一个任务失败时不调用续体，异常原样传给返回的 future
+    template <typename F>
+    auto then(F&& func, ContinuationMode mode = ContinuationMode::INLINE,
+              Priority priority = Priority::HIGH)
+        -> TaskFuture<typename ContinuationResult<T, std::decay_t<F>>::type> {
+        using Fn = std::decay_t<F>;
+        using R = typename ContinuationResult<T, Fn>::type;
+
+        auto next = std::make_shared<FutureState<R>>(state_->pool());
+        state_->onReady([src = state_, promise = TaskPromise<R>(next), fn = Fn(std::forward<F>(func)),
+                         mode, priority]() mutable {
+            ThreadPool* pool = src->pool();
+            if (mode == ContinuationMode::QUEUED && pool != nullptr) {
+                // 被拒绝时 Task 连同 promise 一起销毁，返回的 future 以异常完成
+                submitToPool(pool, Task([src, promise = std::move(promise), fn = std::move(fn)](
+                    const shared_ptr<TransCtx>&) mutable {
+                    runContinuation(*src, promise, fn);
+                }, priority));
+                return;
+            }
+            runContinuation(*src, promise, fn);
+        });
+        return TaskFuture<R>(std::move(next));
+    }
+
+private:
+    template <typename R, typename Fn>
+    static void runContinuation(FutureState<T>& src, TaskPromise<R>& promise, Fn& fn) {
+        if (src.error()) {
+            promise.setError(src.error());
+        } else if constexpr (std::is_void_v<T>) {
+            fulfil(promise, fn);
+        } else {
+            fulfil(promise, fn, src.value());
+        }
+    }
+
+    std::shared_ptr<FutureState<T>> state_;
+};
+
+#endif //FRAME_TASKFUTURE_H
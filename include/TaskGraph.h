@@ -0,0 +1,219 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_TASKGRAPH_H
+#define FRAME_TASKGRAPH_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "ThreadPool.h"
+
+using namespace std;
+
+// 任务依赖图：节点的所有前驱完成后才提交到线程池
+// 每个节点用原子计数记录未完成的前驱数，最后一个前驱完成时由它所在的工作线程提交该节点
+// 某个节点失败（抛异常或被队列丢弃）后，尚未开始的节点不再执行，run 返回的 future 带第一个异常完成
+class TaskGraph {
+public:
+    using NodeId = size_t;
+
+    NodeId add(Task::TaskFunc func, Priority priority = Priority::HIGH) {
+        NodeSpec spec;
+        spec.func = std::move(func);
+        spec.priority = priority;
+        specs_.push_back(std::move(spec));
+        return specs_.size() - 1;
+    }
+
+    // before 完成后 after 才能运行
+    bool precede(NodeId before, NodeId after) {
+        if (before >= specs_.size() || after >= specs_.size() || before == after) {
+            LOG(ERROR) << "TaskGraph invalid edge " << before << " -> " << after;
+            return false;
+        }
+        specs_[before].successors.push_back(after);
+        ++specs_[after].predecessors;
+        return true;
+    }
+
+    [[nodiscard]] size_t size() const { return specs_.size(); }
+
+    // 提交所有入度为 0 的节点，全部节点结束后返回的 future 完成
+    // 节点函数被移入本次运行，图只能运行一次
+    TaskFuture<void> run(ThreadPool& pool) {
+        auto state = std::make_shared<FutureState<void>>(&pool);
+        TaskPromise<void> promise(state);
+        if (launched_) {
+            promise.setError(std::make_exception_ptr(std::logic_error("task graph already run")));
+            return TaskFuture<void>(std::move(state));
+        }
+        if (hasCycle()) {
+            promise.setError(std::make_exception_ptr(std::logic_error("task graph has a cycle")));
+            return TaskFuture<void>(std::move(state));
+        }
+        launched_ = true;
+        if (specs_.empty()) {
+            promise.setValue();
+            return TaskFuture<void>(std::move(state));
+        }
+
+        auto graph_run = std::make_shared<GraphRun>(pool, std::move(specs_), std::move(promise));
+        specs_.clear();
+        graph_run->start();
+        return TaskFuture<void>(std::move(state));
+    }
+
+private:
+    struct NodeSpec {
+        Task::TaskFunc func;
+        Priority priority = Priority::HIGH;
+        std::vector<NodeId> successors;
+        size_t predecessors = 0;
+    };
+
+    // 一次运行的共享状态，由各节点任务持有，图对象可以先于运行结束销毁
+    class GraphRun : public std::enable_shared_from_this<GraphRun> {
+    public:
+        GraphRun(ThreadPool& pool, std::vector<NodeSpec>&& specs, TaskPromise<void>&& promise)
+            : pool_(pool)
+            , specs_(std::move(specs))
+            , pending_(new std::atomic<size_t>[specs_.size()])
+            , remaining_(specs_.size())
+            , failed_(false)
+            , promise_(std::move(promise)) {
+            for (size_t i = 0; i < specs_.size(); ++i) {
+                pending_[i].store(specs_[i].predecessors, std::memory_order_relaxed);
+            }
+        }
+
+        void start() {
+            for (NodeId id = 0; id < specs_.size(); ++id) {
+                if (specs_[id].predecessors == 0) {
+                    schedule(id);
+                }
+            }
+        }
+
+    private:
+        // 节点任务持有的凭据：任务没有执行就被销毁时按失败处理，保证计数能走完
+        struct Ticket {
+            std::shared_ptr<GraphRun> run;
+            NodeId id;
+
+            Ticket(std::shared_ptr<GraphRun> r, NodeId n) : run(std::move(r)), id(n) {}
+            Ticket(Ticket&&) noexcept = default;
+            Ticket(const Ticket &) = delete;
+
+            ~Ticket() {
+                if (run) {
+                    run->fail(std::make_exception_ptr(std::runtime_error("task graph node dropped")));
+                    run->finish(id);
+                }
+            }
+        };
+
+        void schedule(NodeId id) {
+            pool_.submit(Task([ticket = Ticket(shared_from_this(), id)](const shared_ptr<TransCtx>& ctx) mutable {
+                auto run = std::move(ticket.run);
+                run->execute(ticket.id, ctx);
+            }, specs_[id].priority));
+        }
+
+        void execute(NodeId id, const shared_ptr<TransCtx>& ctx) {
+            if (!failed_.load(std::memory_order_acquire)) {
+                try {
+                    specs_[id].func(ctx);
+                } catch (...) {
+                    fail(std::current_exception());
+                }
+            }
+            specs_[id].func.reset();
+            finish(id);
+        }
+
+        void fail(std::exception_ptr error) {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            if (!error_) {
+                error_ = std::move(error);
+            }
+            failed_.store(true, std::memory_order_release);
+        }
+
+        // 节点结束：递减后继的计数，变为 0 的后继提交执行；已失败时后继直接按结束处理
+        void finish(NodeId id) {
+            std::vector<NodeId> done{id};
+            while (!done.empty()) {
+                const NodeId node = done.back();
+                done.pop_back();
+                for (NodeId next : specs_[node].successors) {
+                    if (pending_[next].fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                        continue;
+                    }
+                    if (failed_.load(std::memory_order_acquire)) {
+                        done.push_back(next);
+                    } else {
+                        schedule(next);
+                    }
+                }
+                if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    complete();
+                }
+            }
+        }
+
+        void complete() {
+            std::exception_ptr error;
+            {
+                std::lock_guard<std::mutex> lock(error_mutex_);
+                error = error_;
+            }
+            if (error) {
+                promise_.setError(error);
+            } else {
+                promise_.setValue();
+            }
+        }
+
+        ThreadPool& pool_;
+        std::vector<NodeSpec> specs_;
+        std::unique_ptr<std::atomic<size_t>[]> pending_;
+        std::atomic<size_t> remaining_;
+        std::atomic<bool> failed_;
+        std::mutex error_mutex_;
+        std::exception_ptr error_;
+        TaskPromise<void> promise_;
+    };
+
+    // Kahn 拓扑排序，无法排完即有环
+    bool hasCycle() const {
+        std::vector<size_t> indegree(specs_.size());
+        std::vector<NodeId> ready;
+        for (NodeId id = 0; id < specs_.size(); ++id) {
+            indegree[id] = specs_[id].predecessors;
+            if (indegree[id] == 0) {
+                ready.push_back(id);
+            }
+        }
+        size_t visited = 0;
+        while (!ready.empty()) {
+            const NodeId id = ready.back();
+            ready.pop_back();
+            ++visited;
+            for (NodeId next : specs_[id].successors) {
+                if (--indegree[next] == 0) {
+                    ready.push_back(next);
+                }
+            }
+        }
+        return visited != specs_.size();
+    }
+
+    std::vector<NodeSpec> specs_;
+    bool launched_ = false;
+};
+
+#endif //FRAME_TASKGRAPH_H
@@ -6,12 +6,23 @@
 #define FRAME_TASKQUEUE_H
 
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <atomic>
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <mutex>
+#include <optional>
 #include <utility>
+#include <unordered_map>
+#include <vector>
 #include <condition_variable>
+#include <cmath>
 #include "Logger.h"
+#include "InlineFunction.h"
+#include "RingBuffer.h"
+#include "ShmStats.h"
 #include "TransCtx.h"
 
 using namespace std;
@@ -33,30 +44,152 @@ enum class TaskState {
     TIMEOUT
 };
 
+// 老化策略：任务自提交起等待超过阈值后晋升到上一级队列，0 表示该级不晋升
+// 下标与 Priority 对应：[0]=LOW [1]=NORMAL [2]=HIGH [3]=CRITICAL（CRITICAL 不晋升）
+// 默认全部不晋升，即严格按优先级出队：原先的评分中相邻优先级相差 1000000 分，LOW 每秒只加 5 分，
+// 要等两天以上才能追上 NORMAL，实际上从不越级；需要防饿死时由 scheduler.promoteAfterMs 显式打开
+struct AgingPolicy {
+    std::array<std::chrono::milliseconds, 4> promote_after;
+
+    AgingPolicy() : promote_after{} {}
+};
+
+inline size_t priorityToLane(Priority priority) {
+    return static_cast<size_t>(priority) - static_cast<size_t>(Priority::LOW);
+}
+
+inline Priority laneToPriority(size_t lane) {
+    return static_cast<Priority>(lane + static_cast<size_t>(Priority::LOW));
+}
+
+// 调度参数，默认值即原先写死的常量；下标与 AgingPolicy 相同：[0]=LOW [1]=NORMAL [2]=HIGH [3]=CRITICAL
+struct SchedulerConfig {
+    size_t queueMaxSize;                                  // 未指定容量的队列的准入上限
+    double overflowRatio;                                 // 队列满后 HIGH 及以上可超出的比例
+    std::array<std::chrono::milliseconds, 4> timeout;     // 各优先级默认排队超时，从提交起算
+    std::array<double, 4> agingPerSecond;                 // HEAP 引擎评分每等待一秒的加分
+    AgingPolicy aging;                                    // BUCKET 引擎的晋升阈值
+    std::chrono::milliseconds workerPoll;                 // 工作线程每次等待任务的超时
+
+    SchedulerConfig() :
+        queueMaxSize(1000),
+        overflowRatio(1.2),
+        timeout{
+            std::chrono::milliseconds(200),     // LOW
+            std::chrono::milliseconds(500),     // NORMAL
+            std::chrono::milliseconds(1000),    // HIGH
+            std::chrono::milliseconds(2000)},   // CRITICAL
+        agingPerSecond{5, 2, 1, 0},             // 优先级越低老化越快，CRITICAL 不老化
+        workerPoll(1000) {}
+};
+
+// 进程级的调度参数，运行中可整体替换
+// 读路径不查配置也不加锁：每个线程缓存一份快照，只比较一次代数，发布新参数后才重新复制
+class SchedulerTuning {
+public:
+    static void publish(const SchedulerConfig& conf) {
+        State& state = instance();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.config = conf;
+        state.generation.fetch_add(1, std::memory_order_release);
+    }
+
+    [[nodiscard]] static SchedulerConfig load() {
+        State& state = instance();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        return state.config;
+    }
+
+    [[nodiscard]] static uint64_t generation() {
+        return instance().generation.load(std::memory_order_acquire);
+    }
+
+    // 本线程的快照，引用在本线程下一次调用前有效
+    static const SchedulerConfig& cached() {
+        struct Cache {
+            uint64_t generation = 0;
+            SchedulerConfig config;
+        };
+        thread_local Cache cache;
+        const uint64_t current = generation();
+        if (cache.generation != current) {
+            cache.config = load();
+            cache.generation = current;
+        }
+        return cache.config;
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        SchedulerConfig config;
+        std::atomic<uint64_t> generation{1};
+    };
+
+    static State& instance() {
+        static State state;
+        return state;
+    }
+};
+
+// 各优先级默认的排队超时，任务未显式设置截止时间时从提交起算
+inline std::chrono::milliseconds defaultTimeoutForPriority(Priority priority) {
+    return SchedulerTuning::cached().timeout[priorityToLane(priority)];
+}
+
+// 任务按值保存、只可移动：闭包不超过 64 字节时内联存放，入队到执行全程不分配堆内存
+// 上下文以常量引用传入，执行时不再复制 shared_ptr
 class Task {
 public:
     using TaskFunc_Ctx = std::function<void(shared_ptr<TransCtx>)>;
+    using TaskFunc = InlineFunction<void(const shared_ptr<TransCtx>&), 64>;
+
+    Task() :
+        priority_(Priority::NORMAL),
+        state_(TaskState::PENDING),
+        deadline_(std::chrono::steady_clock::time_point::max()),
+        task_id_(0) {}
 
-    explicit Task(TaskFunc_Ctx func, Priority priority = Priority::HIGH) :
-        func_(std::move(func)),
+    template <typename F,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    explicit Task(F&& func, Priority priority = Priority::HIGH) :
+        func_(std::forward<F>(func)),
         priority_(priority),
         state_(TaskState::PENDING),
         submit_time_(std::chrono::steady_clock::now()),
-        task_id_(next_task_id_++) {}
+        deadline_(submit_time_ + defaultTimeoutForPriority(priority)),
+        task_id_(next_task_id_.fetch_add(1, std::memory_order_relaxed)) {}
+
+    Task(Task&&) noexcept = default;
+    Task& operator=(Task&&) noexcept = default;
+    Task(const Task &) = delete;
+    Task& operator=(const Task &) = delete;
 
     ~Task() = default;
 
+    explicit operator bool() const { return static_cast<bool>(func_); }
+
     [[nodiscard]] Priority getPriority() const { return priority_; }
     [[nodiscard]] uint64_t getTaskId() const { return task_id_; }
     [[nodiscard]] TaskState getState() const { return state_; }
+    [[nodiscard]] std::chrono::steady_clock::time_point getSubmitTime() const { return submit_time_; }
+    [[nodiscard]] std::chrono::steady_clock::time_point getDeadline() const { return deadline_; }
+
+    // 设置绝对截止时间，出队前到期的任务被丢弃并置为 TIMEOUT
+    void setDeadline(std::chrono::steady_clock::time_point deadline) { deadline_ = deadline; }
+    void setTimeout(std::chrono::milliseconds timeout) { deadline_ = submit_time_ + timeout; }
 
-    void execute(shared_ptr<TransCtx> ctx) {
+    [[nodiscard]] bool isExpired(std::chrono::steady_clock::time_point now) const { return now >= deadline_; }
+    void markTimeout() { state_ = TaskState::TIMEOUT; }
+
+    void execute(const shared_ptr<TransCtx>& ctx) {
         state_ = TaskState::RUNNING;
         try {
-            func_(std::move(ctx));
+            func_(ctx);
             state_ = TaskState::COMPLETED;
         } catch (const std::exception& e) {
-            LOG(ERROR) << "Task " << task_id_ << " failed: " << e.what();
+            // 下游故障时每个任务都会失败，限流避免刷屏
+            LOG_PER_SECOND(ERROR, 10) << "Task " << task_id_ << " failed: " << e.what();
             state_ = TaskState::FAILED;
         }
     }
@@ -69,14 +202,9 @@ public:
         // 基础分数
         double base_score = static_cast<double>(priority_) * 1000000;
 
-        // 老化因子：优先级越低，老化越快
-        double aging_factor = 0;
-        switch (priority_) {
-            case Priority::CRITICAL: aging_factor = 0; break;      // 不老化
-            case Priority::HIGH: aging_factor = static_cast<double>(wait_time); break;   // 每秒+1
-            case Priority::NORMAL: aging_factor = static_cast<double>(wait_time) * 2; break; // 每秒+2
-            case Priority::LOW: aging_factor = static_cast<double>(wait_time) * 5; break;    // 每秒+5
-        }
+        // 老化因子：优先级越低，老化越快，每秒加分由调度参数给出
+        const double aging_factor = static_cast<double>(wait_time)
+            * SchedulerTuning::cached().agingPerSecond[priorityToLane(priority_)];
 
         // 加上微秒时间戳确保FIFO（同优先级）
         auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
@@ -91,10 +219,11 @@ public:
         return elapsed > timeout_ms;
     }
 private:
-    TaskFunc_Ctx func_{};
+    TaskFunc func_;
     Priority priority_;
     TaskState state_;
     std::chrono::steady_clock::time_point submit_time_;
+    std::chrono::steady_clock::time_point deadline_;
     uint64_t task_id_;
     static std::atomic<uint64_t> next_task_id_;
 };
@@ -102,84 +231,480 @@ std::atomic<uint64_t> Task::next_task_id_{0};
 
 // 优先级队列比较器
 struct TaskComparator {
-    bool operator()(const std::shared_ptr<Task>& a, const std::shared_ptr<Task>& b) const {
+    bool operator()(const Task& a, const Task& b) const {
         // 大顶堆
-        return a->getScore() < b->getScore();
+        return a.getScore() < b.getScore();
     }
 };
 
+// 队列引擎
+enum class QueueEngine {
+    BUCKET,     // 按优先级分桶的 FIFO 队列 + 显式晋升，O(1)
+    HEAP,       // 基于 getScore 的大顶堆，O(log n)，仅用于对比
+    RING        // 每个优先级一个无锁有界环形队列，入队不加锁，不支持晋升
+};
+
+// 分桶队列：每个优先级一条 FIFO，出队时只检查低优先级队头是否需要晋升
+// 晋升来的任务进同级的 promoted 队列，出队时与本级队列比较队头的提交时间，先提交的先出，
+// 晋升的任务不会排到晋升之后才提交的任务后面
+// 比较过程中不读时钟，每次出队最多读一次时钟
+class TaskLanes {
+public:
+    static constexpr size_t kLaneCount = 4;
+
+    explicit TaskLanes(const AgingPolicy& aging = AgingPolicy()) : aging_(aging), size_(0) {}
+
+    void push(Task&& task) {
+        lanes_[priorityToLane(task.getPriority())].native.push(std::move(task));
+        ++size_;
+    }
+
+    bool pop(Task& out) {
+        if (size_ == 0) {
+            return false;
+        }
+        promote();
+        for (size_t lane = kLaneCount; lane-- > 0;) {
+            if (!lanes_[lane].empty()) {
+                FifoBuffer<Task>& from = lanes_[lane].oldest().tasks;
+                out = std::move(from.front());
+                from.pop_front();
+                --size_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+    [[nodiscard]] size_t laneSize(Priority priority) const { return lanes_[priorityToLane(priority)].size(); }
+    [[nodiscard]] const AgingPolicy& aging() const { return aging_; }
+    void setAging(const AgingPolicy& aging) { aging_ = aging; }
+
+    // 移出已到期的任务：截止时间单调的队列遇到未到期的队头即停，O(到期数)；不单调的整条扫描，O(长度)
+    size_t sweep(std::chrono::steady_clock::time_point now, std::vector<Task>& out) {
+        size_t count = 0;
+        for (auto& lane : lanes_) {
+            count += lane.native.sweep(now, out);
+            count += lane.promoted.sweep(now, out);
+        }
+        size_ -= count;
+        return count;
+    }
+
+    // 当前最高的非空队列（不触发晋升），调用前需确认非空
+    [[nodiscard]] Priority topPriority() const {
+        for (size_t lane = kLaneCount; lane-- > 0;) {
+            if (!lanes_[lane].empty()) {
+                return laneToPriority(lane);
+            }
+        }
+        return Priority::LOW;
+    }
+
+private:
+    // 按提交时间有序的 FIFO，另记截止时间是否随之单调：默认超时下单调，清理只看队头，O(到期数)
+    // setDeadline / setTimeout 或不同优先级晋升混入后不再单调，记为 unordered：
+    // 最早截止时间未到时清理直接返回，到了才整条扫描一遍，O(队长)，扫描后重新判断是否单调
+    struct Fifo {
+        FifoBuffer<Task> tasks;
+        std::chrono::steady_clock::time_point last_deadline = std::chrono::steady_clock::time_point::min();
+        // 队中任务截止时间的下界，出队不更新，只可能偏早，扫描时重算
+        std::chrono::steady_clock::time_point earliest = std::chrono::steady_clock::time_point::max();
+        bool unordered = false;
+
+        void push(Task&& task) {
+            if (task.getDeadline() < last_deadline) {
+                unordered = true;
+            } else {
+                last_deadline = task.getDeadline();
+            }
+            earliest = std::min(earliest, task.getDeadline());
+            tasks.push_back(std::move(task));
+        }
+
+        size_t sweep(std::chrono::steady_clock::time_point now, std::vector<Task>& out) {
+            size_t count = 0;
+            if (!unordered) {
+                while (!tasks.empty() && tasks.front().isExpired(now)) {
+                    out.push_back(std::move(tasks.front()));
+                    tasks.pop_front();
+                    ++count;
+                }
+                return count;
+            }
+            if (tasks.empty() || now < earliest) {
+                return 0;
+            }
+            // 到期的移出，其余按原顺序放回，同时重新判断是否单调
+            last_deadline = std::chrono::steady_clock::time_point::min();
+            earliest = std::chrono::steady_clock::time_point::max();
+            unordered = false;
+            for (size_t n = tasks.size(); n > 0; --n) {
+                Task task = std::move(tasks.front());
+                tasks.pop_front();
+                if (task.isExpired(now)) {
+                    out.push_back(std::move(task));
+                    ++count;
+                } else {
+                    push(std::move(task));
+                }
+            }
+            return count;
+        }
+    };
+
+    // 一个优先级的两条 FIFO，各自按提交时间有序
+    struct Lane {
+        Fifo native;        // 以本优先级提交的任务
+        Fifo promoted;      // 从下一级晋升来的任务，晋升时按提交时间归并，仍然有序
+
+        [[nodiscard]] size_t size() const { return native.tasks.size() + promoted.tasks.size(); }
+        [[nodiscard]] bool empty() const { return native.tasks.empty() && promoted.tasks.empty(); }
+
+        // 队头提交更早的一条，调用前需确认非空
+        Fifo& oldest() {
+            if (promoted.tasks.empty()) {
+                return native;
+            }
+            if (native.tasks.empty()) {
+                return promoted;
+            }
+            return promoted.tasks.front().getSubmitTime() <= native.tasks.front().getSubmitTime() ? promoted : native;
+        }
+    };
+
+    // 晋升：每个任务最多晋升 kLaneCount-1 次，均摊 O(1)
+    // 从两条 FIFO 中按提交时间依次取出到期的任务，目标优先级的 promoted 队列因此保持有序
+    void promote() {
+        bool has_lower = false;
+        for (size_t lane = 0; lane + 1 < kLaneCount; ++lane) {
+            if (!lanes_[lane].empty() && aging_.promote_after[lane].count() > 0) {
+                has_lower = true;
+                break;
+            }
+        }
+        if (!has_lower) {
+            return;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        for (size_t lane = 0; lane + 1 < kLaneCount; ++lane) {
+            const auto threshold = aging_.promote_after[lane];
+            if (threshold.count() <= 0) {
+                continue;
+            }
+            Lane& from = lanes_[lane];
+            while (!from.empty()) {
+                FifoBuffer<Task>& fifo = from.oldest().tasks;
+                if (now - fifo.front().getSubmitTime() < threshold) {
+                    break;
+                }
+                lanes_[lane + 1].promoted.push(std::move(fifo.front()));
+                fifo.pop_front();
+            }
+        }
+    }
+
+    AgingPolicy aging_;
+    std::array<Lane, kLaneCount> lanes_;
+    size_t size_;
+};
+
+// 原有的评分堆，保留用于基准对比
+class TaskHeap {
+public:
+    void push(Task&& task) {
+        heap_.push_back(std::move(task));
+        std::push_heap(heap_.begin(), heap_.end(), TaskComparator());
+    }
+
+    bool pop(Task& out) {
+        if (heap_.empty()) {
+            return false;
+        }
+        std::pop_heap(heap_.begin(), heap_.end(), TaskComparator());
+        out = std::move(heap_.back());
+        heap_.pop_back();
+        return true;
+    }
+
+    [[nodiscard]] size_t size() const { return heap_.size(); }
+    [[nodiscard]] bool empty() const { return heap_.empty(); }
+    [[nodiscard]] Priority topPriority() const { return heap_.front().getPriority(); }
+
+    // 移出已到期的任务后重建堆，O(n)
+    size_t sweep(std::chrono::steady_clock::time_point now, std::vector<Task>& out) {
+        const auto live_end = std::partition(heap_.begin(), heap_.end(),
+                                             [now](const Task& task) { return !task.isExpired(now); });
+        const auto count = static_cast<size_t>(heap_.end() - live_end);
+        if (count == 0) {
+            return 0;
+        }
+        std::move(live_end, heap_.end(), std::back_inserter(out));
+        heap_.erase(live_end, heap_.end());
+        std::make_heap(heap_.begin(), heap_.end(), TaskComparator());
+        return count;
+    }
+
+private:
+    std::vector<Task> heap_;
+};
+
+// 单个优先级的队列统计
+struct QueueStats {
+    size_t queued;      // 当前排队数（RING 引擎不分优先级统计，为 0）
+    uint64_t expired;   // 累计到期丢弃数
+
+    QueueStats() : queued(0), expired(0) {}
+};
+
+// 批量入队结果，部分准入时调用方据此处理被拒绝的任务
+struct BatchResult {
+    size_t accepted;
+    size_t rejected;
+
+    BatchResult() : accepted(0), rejected(0) {}
+};
+
 class PriorityTaskQueue {
 public:
-    explicit PriorityTaskQueue(size_t max_size = 1000)
-        : max_size_(max_size)
+    // 任务到期被丢弃时调用，此时任务已置为 TIMEOUT；调用时不持有队列锁
+    using ExpiryCallback = std::function<void(Task&)>;
+
+    // max_size 为 0 时容量跟随 SchedulerTuning 的 queueMaxSize，未指定 aging 时晋升阈值同样跟随
+    // 超出比例总是跟随 SchedulerTuning；参数在准入和出队时按代数检查，发布后下一次操作生效
+    explicit PriorityTaskQueue(size_t max_size = 0,
+        QueueEngine engine = QueueEngine::BUCKET,
+        std::optional<AgingPolicy> aging = std::nullopt)
+        : lanes_(aging ? *aging : SchedulerTuning::cached().aging)
+        , engine_(engine)
+        , fixed_max_size_(max_size)
+        , fixed_aging_(std::move(aging))
         , stopped_(false) {
+        applyTuning(SchedulerTuning::generation());
+        if (engine_ == QueueEngine::RING) {
+            // 容量按准入上限分配，准入计数保证 tryPush 不会因满失败
+            // 环的容量构造后不再改变，运行中调大的上限超出容量的部分不生效
+            for (size_t lane = 0; lane < TaskLanes::kLaneCount; ++lane) {
+                const size_t capacity = laneToPriority(lane) < Priority::HIGH ? max_size_.load() : overflow_limit_.load();
+                rings_[lane] = std::make_unique<MpmcRing<Task>>(capacity);
+            }
+        }
     }
 
     ~PriorityTaskQueue() {
         stop();
     }
 
-    // 推送任务
-    bool push(const std::shared_ptr<Task>& task) {
-        std::unique_lock<std::mutex> lock(mutex_);
-
-        if (stopped_) return false;
-
-        // 检查队列是否已满
-        if (queue_.size() >= max_size_) {
-            // 如果不是高优先级，拒绝
-            if (task->getPriority() < Priority::HIGH) {
-                return false;
-            }
-            // 高优先级且队列已满
-            if (static_cast<double>(queue_.size()) >=
-                static_cast<double>(max_size_) * 1.2) {
+    // 推送任务，被拒绝时 task 保持不变
+    bool push(Task&& task) {
+        if (engine_ == QueueEngine::RING) {
+            if (!ringAdmit(task)) {
                 return false;
             }
+            ringWake(1);
+            return true;
         }
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (stopped_ || admission_closed_) return false;
 
-        queue_.push(task);
+        if (!admit(task)) {
+            return false;
+        }
         cv_.notify_one();
         return true;
     }
 
-    // 弹出任务（阻塞）
-    std::shared_ptr<Task> pop(int timeout_ms = -1) {
-        std::unique_lock<std::mutex> lock(mutex_);
-
-        while (queue_.empty() && !stopped_) {
-            if (timeout_ms > 0) {
-                if (cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms))
-                    == std::cv_status::timeout) {
-                    return nullptr;
+    // 批量推送任务：只加一次锁，按准入规则逐个判断，最后按接收数量唤醒一次
+    // 接收的任务被移走；rejected_out 非空时被拒绝的任务移入其中，否则留在原位
+    template <typename It>
+    BatchResult pushBatch(It first, It last, std::vector<Task>* rejected_out = nullptr) {
+        BatchResult result;
+        if (engine_ == QueueEngine::RING) {
+            for (; first != last; ++first) {
+                if (ringAdmit(*first)) {
+                    ++result.accepted;
+                } else {
+                    ++result.rejected;
+                    if (rejected_out) rejected_out->push_back(std::move(*first));
                 }
+            }
+            ringWake(result.accepted);
+            return result;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (; first != last; ++first) {
+            if (!stopped_ && !admission_closed_ && admit(*first)) {
+                ++result.accepted;
             } else {
-                cv_.wait(lock);
+                ++result.rejected;
+                if (rejected_out) rejected_out->push_back(std::move(*first));
+            }
+        }
+        if (result.accepted >= waiters_) {
+            cv_.notify_all();
+        } else {
+            for (size_t i = 0; i < result.accepted; ++i) {
+                cv_.notify_one();
+            }
+        }
+        return result;
+    }
+
+    BatchResult pushBatch(std::vector<Task>& tasks, std::vector<Task>* rejected_out = nullptr) {
+        return pushBatch(tasks.begin(), tasks.end(), rejected_out);
+    }
+
+    // 设置到期回调，应在开始提交任务前设置
+    void setExpiryCallback(ExpiryCallback callback) {
+        std::atomic_store(&expiry_callback_, std::make_shared<ExpiryCallback>(std::move(callback)));
+        markSweepWanted();
+    }
+
+    // 周期清理是否有意义：设置了到期回调，或入队过有截止时间的任务；RING 引擎不支持清理，总是 false
+    // 任务默认带按优先级的超时，截止时间都是有限的，所以实际上第一个任务入队后即为 true；
+    // 只有从未入队、或只入队过显式设为无限截止时间的任务且没有回调时才是 false
+    // ThreadPool 据此推迟定时线程的启动，空闲的池在第一个任务到来之前不多一个线程
+    [[nodiscard]] bool wantsSweep() const { return sweep_wanted_.load(std::memory_order_relaxed); }
+
+    // 队列之外发现的到期任务（工作窃取的本地队列出队时）交给本队列，按同样的方式计数、置 TIMEOUT 并回调
+    // 调用时不持有任何队列锁
+    void reportExpired(std::vector<Task>& expired) {
+        for (const auto& task : expired) {
+            countExpired(task);
+        }
+        notifyExpired(expired, std::atomic_load(&expiry_callback_));
+    }
+
+    // 主动清理到期任务，供后台线程周期调用，使到期任务不必等到出队才被发现
+    // BUCKET 与 HEAP 引擎都会找出排在未到期任务之后的到期任务；RING 引擎无锁，不能从中间移除，到期任务仍在出队时丢弃
+    size_t sweepExpired(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) {
+        if (engine_ == QueueEngine::RING) {
+            return 0;
+        }
+        std::vector<Task> expired;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const size_t swept = engine_ == QueueEngine::BUCKET ? lanes_.sweep(now, expired) : heap_.sweep(now, expired);
+            if (swept == 0 && expired_.empty()) {
+                return 0;
+            }
+            depth_stat_.set(storeSize());
+            for (const auto& task : expired) {
+                countExpired(task);
+            }
+            if (!expired_.empty()) {
+                std::move(expired_.begin(), expired_.end(), std::back_inserter(expired));
+                expired_.clear();
             }
         }
+        const size_t count = expired.size();
+        notifyExpired(expired, std::atomic_load(&expiry_callback_));
+        return count;
+    }
 
-        if (stopped_ && queue_.empty()) {
-            return nullptr;
+    // 弹出任务（阻塞）
+    std::optional<Task> pop(int timeout_ms = -1) {
+        Task task;
+        if (!popInto(task, timeout_ms, nullptr)) {
+            return std::nullopt;
         }
+        return std::optional<Task>(std::move(task));
+    }
 
-        auto task = queue_.top();
-        queue_.pop();
+    // 弹出任务（阻塞），等待期间若有人调用 wakeWaiters() 则提前返回空
+    // wake_epoch 需在检查其它任务来源之前通过 wakeEpoch() 取得，避免丢失唤醒
+    std::optional<Task> pop(int timeout_ms, uint64_t wake_epoch) {
+        Task task;
+        if (!popInto(task, timeout_ms, &wake_epoch)) {
+            return std::nullopt;
+        }
+        return std::optional<Task>(std::move(task));
+    }
+
+    // 批量弹出：阻塞等到第一个任务后，在同一次加锁内最多取出 max_n 个，追加到 out
+    // 返回取出的数量，超时或停止时返回 0
+    size_t popBatch(std::vector<Task>& out, size_t max_n, int timeout_ms = -1) {
+        if (max_n == 0) {
+            return 0;
+        }
+        Task task;
+        if (engine_ == QueueEngine::RING) {
+            if (!ringWaitAndPop(task, timeout_ms, nullptr)) {
+                return 0;
+            }
+            out.push_back(std::move(task));
+            size_t count = 1;
+            while (count < max_n && ringTryPop(task, Priority::LOW)) {
+                out.push_back(std::move(task));
+                ++count;
+            }
+            return count;
+        }
 
-        // 检查任务是否超时
-        int task_timeout = getTimeoutForPriority(task->getPriority());
-        if (task->isTimeout(task_timeout)) {
-            // 超时任务直接丢弃，递归获取下一个
-            return pop(timeout_ms);
+        std::unique_lock<std::mutex> lock(mutex_);
+        size_t count = 0;
+        if (waitAndPop(lock, task, timeout_ms, nullptr)) {
+            out.push_back(std::move(task));
+            count = 1;
+            while (count < max_n && popReady(task, Priority::LOW)) {
+                out.push_back(std::move(task));
+                ++count;
+            }
         }
+        flushExpired(lock);
+        return count;
+    }
 
-        return task;
+    // 非阻塞弹出，仅当队首优先级不低于 at_least 时才出队
+    std::optional<Task> tryPop(Priority at_least = Priority::LOW) {
+        Task task;
+        bool found;
+        if (engine_ == QueueEngine::RING) {
+            found = ringTryPop(task, at_least);
+        } else {
+            std::unique_lock<std::mutex> lock(mutex_);
+            found = popReady(task, at_least);
+            flushExpired(lock);
+        }
+        if (!found) {
+            return std::nullopt;
+        }
+        return std::optional<Task>(std::move(task));
+    }
+
+    [[nodiscard]] uint64_t wakeEpoch() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return wake_epoch_;
+    }
+
+    // 唤醒所有阻塞在 pop(timeout_ms, wake_epoch) 上的线程，不入队任务
+    void wakeWaiters() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++wake_epoch_;
+        }
+        cv_.notify_all();
     }
 
     size_t size() const {
+        if (engine_ == QueueEngine::RING) {
+            return ring_size_.load();
+        }
         std::lock_guard<std::mutex> lock(mutex_);
-        return queue_.size();
+        return storeSize();
     }
 
+    [[nodiscard]] QueueEngine engine() const { return engine_; }
+    // 当前生效的准入上限
+    [[nodiscard]] size_t maxSize() const { return max_size_.load(std::memory_order_relaxed); }
+    // 构造参数，0 与空表示跟随调度参数，用于创建同样配置的队列
+    [[nodiscard]] size_t fixedMaxSize() const { return fixed_max_size_; }
+    [[nodiscard]] const std::optional<AgingPolicy>& fixedAging() const { return fixed_aging_; }
+
     void stop() {
         {
             std::lock_guard<std::mutex> lock(mutex_);
@@ -188,36 +713,353 @@ public:
         cv_.notify_all();
     }
 
+    // 优雅停止的第一步：之后的入队一律拒绝，已入队的任务照常出队，消费者照常阻塞等待
+    void closeAdmission() {
+        admission_closed_ = true;
+    }
+
+    [[nodiscard]] bool admissionClosed() const {
+        return admission_closed_.load();
+    }
+
+    // 出队计数：之后每取出一个未到期的任务，在出队的同一临界区内（RING 引擎在深度减少之前）给 counter 加 1
+    // 消费者执行完后自行减去；任务因此总在深度或 counter 之一中可见，排空检查不会在两者之间漏掉它
+    // counter 须在队列使用期间有效，传 nullptr 解除
+    void trackInFlight(std::atomic<size_t>* counter) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_.store(counter);
+    }
+
     // 获取各优先级统计信息
-    std::unordered_map<Priority, size_t> getStats() const {
+    std::unordered_map<Priority, QueueStats> getStats() const {
         std::lock_guard<std::mutex> lock(mutex_);
-        std::unordered_map<Priority, size_t> stats;
-        // 维护计数器
-        stats[Priority::CRITICAL] = 0;
-        stats[Priority::HIGH] = 0;
-        stats[Priority::NORMAL] = 0;
-        stats[Priority::LOW] = 0;
+        std::unordered_map<Priority, QueueStats> stats;
+        for (size_t lane = 0; lane < TaskLanes::kLaneCount; ++lane) {
+            QueueStats& entry = stats[laneToPriority(lane)];
+            if (engine_ == QueueEngine::BUCKET) {
+                entry.queued = lanes_.laneSize(laneToPriority(lane));
+            }
+            entry.expired = expired_count_[lane].load(std::memory_order_relaxed);
+        }
         return stats;
     }
 
+    // 某一优先级累计到期丢弃数
+    [[nodiscard]] uint64_t getExpiredCount(Priority priority) const {
+        return expired_count_[priorityToLane(priority)].load(std::memory_order_relaxed);
+    }
+
 private:
-    static int getTimeoutForPriority(Priority priority) {
-        switch (priority) {
-            case Priority::CRITICAL: return 2000;  // 2秒
-            case Priority::HIGH: return 1000;      // 1秒
-            case Priority::NORMAL: return 500;     // 500ms
-            case Priority::LOW: return 200;        // 200ms
-            default: return 1000;
+    bool popInto(Task& out, int timeout_ms, const uint64_t* wake_epoch) {
+        if (engine_ == QueueEngine::RING) {
+            return ringWaitAndPop(out, timeout_ms, wake_epoch);
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        const bool found = waitAndPop(lock, out, timeout_ms, wake_epoch);
+        flushExpired(lock);
+        return found;
+    }
+
+    void countExpired(const Task& task) {
+        expired_count_[priorityToLane(task.getPriority())].fetch_add(1, std::memory_order_relaxed);
+        expired_stat_.fetchAdd();
+    }
+
+    // 出队时发现的到期任务先暂存，释放锁后再回调和析构
+    // 析构可能完成 future 并内联执行后续逻辑，其中可能再次提交到本队列
+    void flushExpired(std::unique_lock<std::mutex>& lock) {
+        if (expired_.empty()) {
+            return;
+        }
+        std::vector<Task> expired;
+        expired.swap(expired_);
+        lock.unlock();
+        notifyExpired(expired, std::atomic_load(&expiry_callback_));
+    }
+
+    static void notifyExpired(std::vector<Task>& expired, const std::shared_ptr<ExpiryCallback>& callback) {
+        for (auto& task : expired) {
+            task.markTimeout();
+            if (callback && *callback) {
+                (*callback)(task);
+            }
+        }
+        LOG(DEBUG) << "Expired " << expired.size() << " queued tasks";
+        expired.clear();
+    }
+
+    // wake_epoch 为空时忽略 wakeWaiters()
+    bool waitAndPop(std::unique_lock<std::mutex>& lock, Task& out, int timeout_ms, const uint64_t* wake_epoch) {
+        while (true) {
+            while (storeSize() == 0 && !stopped_) {
+                if (wake_epoch && wake_epoch_ != *wake_epoch) {
+                    return false;
+                }
+                if (!expired_.empty()) {
+                    // 睡眠前先处理已丢弃的到期任务，避免回调被推迟到下次唤醒
+                    flushExpired(lock);
+                    lock.lock();
+                    continue;
+                }
+                ++waiters_;
+                bool timed_out = false;
+                if (timeout_ms > 0) {
+                    timed_out = cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms))
+                        == std::cv_status::timeout;
+                } else {
+                    cv_.wait(lock);
+                }
+                --waiters_;
+                if (timed_out) {
+                    return false;
+                }
+            }
+
+            if (stopped_ && storeSize() == 0) {
+                return false;
+            }
+
+            if (popReady(out, Priority::LOW)) {
+                return true;
+            }
+        }
+    }
+
+    // 出队一个未到期的任务，到期任务移入 expired_，调用方需持有 mutex_ 并在释放前调用 flushExpired
+    bool popReady(Task& out, Priority at_least) {
+        refreshTuning();
+        std::chrono::steady_clock::time_point now;
+        bool have_now = false;
+        while (storeSize() > 0) {
+            if (storeTopPriority() < at_least) {
+                return false;
+            }
+            storePop(out);
+            depth_stat_.set(storeSize());
+            if (!have_now) {
+                now = std::chrono::steady_clock::now();
+                have_now = true;
+            }
+            if (!out.isExpired(now)) {
+                raiseInFlight();
+                return true;
+            }
+            countExpired(out);
+            expired_.push_back(std::move(out));
+        }
+        return false;
+    }
+
+    // 准入检查并入队，成功时移走 task，调用方需持有 mutex_
+    bool admit(Task& task) {
+        refreshTuning();
+        // 检查队列是否已满
+        const size_t queued = storeSize();
+        if (queued >= max_size_.load(std::memory_order_relaxed)) {
+            // 如果不是高优先级，拒绝
+            if (task.getPriority() < Priority::HIGH) {
+                rejected_stat_.add();
+                return false;
+            }
+            // 高优先级且队列已满
+            if (queued >= overflow_limit_.load(std::memory_order_relaxed)) {
+                rejected_stat_.add();
+                return false;
+            }
+        }
+        storePush(std::move(task));
+        depth_stat_.set(queued + 1);
+        return true;
+    }
+
+    // 无锁入队：先按准入上限预占计数，再写入对应优先级的环，成功时移走 task
+    bool ringAdmit(Task& task) {
+        if (stopped_ || admission_closed_) return false;
+
+        if (tuning_generation_.load(std::memory_order_relaxed) != SchedulerTuning::generation()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            refreshTuning();
+        }
+        const Priority priority = task.getPriority();
+        const size_t limit = (priority < Priority::HIGH ? max_size_ : overflow_limit_).load(std::memory_order_relaxed);
+        const size_t queued = ring_size_.fetch_add(1);
+        if (queued >= limit) {
+            ring_size_.fetch_sub(1);
+            rejected_stat_.fetchAdd();
+            return false;
+        }
+        if (!rings_[priorityToLane(priority)]->tryPush(std::move(task))) {
+            ring_size_.fetch_sub(1);
+            rejected_stat_.fetchAdd();
+            return false;
+        }
+        depth_stat_.set(queued + 1);
+        return true;
+    }
+
+    // 只有确实有线程睡眠时才加锁唤醒，count 为本次入队数量
+    void ringWake(size_t count) {
+        if (count == 0 || ring_sleepers_.load() == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (count >= ring_sleepers_.load()) {
+            cv_.notify_all();
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                cv_.notify_one();
+            }
+        }
+    }
+
+    bool ringTryPop(Task& out, Priority at_least) {
+        for (size_t lane = TaskLanes::kLaneCount; lane-- > priorityToLane(at_least);) {
+            while (rings_[lane]->tryPop(out)) {
+                const bool expired = out.isExpired(std::chrono::steady_clock::now());
+                if (!expired) {
+                    raiseInFlight();
+                }
+                depth_stat_.set(ring_size_.fetch_sub(1) - 1);
+                if (!expired) {
+                    return true;
+                }
+                // 无锁路径，直接回调
+                countExpired(out);
+                out.markTimeout();
+                std::shared_ptr<ExpiryCallback> callback = std::atomic_load(&expiry_callback_);
+                if (callback && *callback) {
+                    (*callback)(out);
+                }
+                out = Task();
+            }
+        }
+        return false;
+    }
+
+    // 先自旋一小段时间，仍无任务再登记睡眠
+    // 登记 ring_sleepers_ 后重新检查 ring_size_，与 ringPush 的“先计数后读睡眠数”配对，不会丢失唤醒
+    bool ringWaitAndPop(Task& out, int timeout_ms, const uint64_t* wake_epoch) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (true) {
+            for (int spin = 0; spin < kRingSpins; ++spin) {
+                if (ringTryPop(out, Priority::LOW)) {
+                    return true;
+                }
+                if (stopped_) {
+                    return false;
+                }
+                cpuRelax();
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (wake_epoch && wake_epoch_ != *wake_epoch) {
+                return false;
+            }
+            ring_sleepers_.fetch_add(1);
+            bool timed_out = false;
+            if (ring_size_.load() == 0 && !stopped_) {
+                if (timeout_ms > 0) {
+                    timed_out = cv_.wait_until(lock, deadline) == std::cv_status::timeout;
+                } else {
+                    cv_.wait(lock);
+                }
+            }
+            ring_sleepers_.fetch_sub(1);
+            if (timed_out) {
+                return false;
+            }
+        }
+    }
+
+    // 调度参数有新代数时重新取值，调用方需持有 mutex_；未变化时只有一次原子读
+    void refreshTuning() {
+        const uint64_t generation = SchedulerTuning::generation();
+        if (tuning_generation_.load(std::memory_order_relaxed) != generation) {
+            applyTuning(generation);
+        }
+    }
+
+    void applyTuning(uint64_t generation) {
+        const SchedulerConfig& conf = SchedulerTuning::cached();
+        const size_t max_size = fixed_max_size_ > 0 ? fixed_max_size_ : conf.queueMaxSize;
+        max_size_.store(max_size, std::memory_order_relaxed);
+        overflow_limit_.store(static_cast<size_t>(std::ceil(static_cast<double>(max_size) * conf.overflowRatio)),
+                              std::memory_order_relaxed);
+        if (!fixed_aging_) {
+            lanes_.setAging(conf.aging);
+        }
+        tuning_generation_.store(generation, std::memory_order_relaxed);
+    }
+
+    // 按引擎分发，调用方需持有 mutex_
+    [[nodiscard]] size_t storeSize() const {
+        return engine_ == QueueEngine::BUCKET ? lanes_.size() : heap_.size();
+    }
+
+    void storePush(Task&& task) {
+        if (task.getDeadline() != std::chrono::steady_clock::time_point::max()) {
+            markSweepWanted();
+        }
+        if (engine_ == QueueEngine::BUCKET) {
+            lanes_.push(std::move(task));
+        } else {
+            heap_.push(std::move(task));
+        }
+    }
+
+    bool storePop(Task& out) {
+        return engine_ == QueueEngine::BUCKET ? lanes_.pop(out) : heap_.pop(out);
+    }
+
+    [[nodiscard]] Priority storeTopPriority() const {
+        return engine_ == QueueEngine::BUCKET ? lanes_.topPriority() : heap_.topPriority();
+    }
+
+    void raiseInFlight() {
+        if (std::atomic<size_t>* counter = in_flight_.load()) {
+            counter->fetch_add(1);
+        }
+    }
+
+    void markSweepWanted() {
+        if (engine_ != QueueEngine::RING && !sweep_wanted_.load(std::memory_order_relaxed)) {
+            sweep_wanted_.store(true, std::memory_order_relaxed);
         }
     }
 
     mutable std::mutex mutex_;
     std::condition_variable cv_;
-    std::priority_queue<std::shared_ptr<Task>,
-                       std::vector<std::shared_ptr<Task>>,
-                       TaskComparator> queue_;
-    size_t max_size_;
-    bool stopped_;
+    TaskLanes lanes_;
+    TaskHeap heap_;
+    QueueEngine engine_;
+    const size_t fixed_max_size_;
+    const std::optional<AgingPolicy> fixed_aging_;
+    // 当前生效的调度参数，在 mutex_ 内更新，RING 引擎无锁读取
+    std::atomic<size_t> max_size_{0};
+    std::atomic<size_t> overflow_limit_{0};
+    std::atomic<uint64_t> tuning_generation_{0};
+    std::atomic<bool> stopped_;
+    std::atomic<bool> admission_closed_{false};
+    std::atomic<std::atomic<size_t>*> in_flight_{nullptr};
+    uint64_t wake_epoch_ = 0;
+    size_t waiters_ = 0;
+
+    // 到期处理
+    std::vector<Task> expired_;
+    std::shared_ptr<ExpiryCallback> expiry_callback_;
+    std::array<std::atomic<uint64_t>, TaskLanes::kLaneCount> expired_count_{};
+    std::atomic<bool> sweep_wanted_{false};
+
+    // RING 引擎
+    static constexpr int kRingSpins = 128;
+    std::array<std::unique_ptr<MpmcRing<Task>>, TaskLanes::kLaneCount> rings_;
+    alignas(64) std::atomic<size_t> ring_size_{0};
+    alignas(64) std::atomic<size_t> ring_sleepers_{0};
+
+    // 运行时统计：BUCKET 与 HEAP 引擎在锁内写入；RING 引擎深度由入队出队线程顺带写入，为近似值
+    StatCell depth_stat_ = ShmStats::gauge("queue.depth");
+    StatCell rejected_stat_ = ShmStats::counter("queue.rejected");
+    StatCell expired_stat_ = ShmStats::counter("queue.expired");
 };
 
 #endif //FRAME_TASKQUEUE_H
\ No newline at end of file
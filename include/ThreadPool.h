@@ -5,26 +5,180 @@
 #ifndef FRAME_THREADPOOL_H
 #define FRAME_THREADPOOL_H
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <utility>
+#include <vector>
+#include <unistd.h>
 #include <TaskQueue.h>
+#include <WorkStealQueue.h>
+#include <TimerWheel.h>
+#include <TaskFuture.h>
+#include <CpuTopology.h>
+#include <LatencyHistogram.h>
+#include <ShmStats.h>
 #include "Logger.h"
 
+// 调度模式
+enum class SchedulerMode {
+    GLOBAL_QUEUE,   // 所有线程共享一个 PriorityTaskQueue
+    WORK_STEALING,  // 每个线程一个本地队列，空闲时从其它线程窃取
+    NUMA_AWARE      // 每个 NUMA 节点一个队列，工作线程绑定到所在节点，本节点空闲时才跨节点窃取
+};
+
+// NUMA_AWARE 模式下任务放到哪个节点
+enum class NodePlacement {
+    LOCAL_NODE,     // 提交线程所在节点
+    ANY_NODE        // 有空闲线程的节点优先，否则轮转
+};
+
+// 线程池配置
+struct ThreadPoolConfig {
+    size_t numThreads;             // 工作线程数；弹性模式下为初始线程数
+    SchedulerMode mode;            // 调度模式
+    size_t batchSize;              // 全局队列模式下每次唤醒最多取出的任务数，1 表示逐个取
+    bool pinThreads;               // 每个工作线程绑定到一个核；NUMA_AWARE 模式下不设置时绑定到整个节点
+    std::chrono::milliseconds expirySweep;     // 定时线程清理队列中到期任务的间隔，0 表示只在出队时检查；RING 引擎不支持
+    bool latencyMetrics;                       // 按优先级记录排队、执行与总延迟直方图
+
+    // 弹性伸缩，仅全局队列模式
+    bool elastic;                              // 是否按负载增减工作线程
+    size_t minThreads;                         // 最少线程数
+    size_t maxThreads;                         // 最多线程数
+    std::chrono::milliseconds keepAlive;       // 空闲超过该时长的线程退出
+    std::chrono::milliseconds scaleInterval;   // 扩容检查间隔
+    size_t growQueueDepth;                     // 平均每个线程积压的任务数超过该值才考虑扩容
+    std::chrono::milliseconds growWait;        // 任务排队时间超过该值才考虑扩容
+    size_t growSustain;                        // 连续多少次检查满足条件才扩容
+    std::chrono::milliseconds resizeCooldown;  // 扩容后多久内不缩容
+
+    ThreadPoolConfig() :
+        numThreads(4),
+        mode(SchedulerMode::GLOBAL_QUEUE),
+        batchSize(1),
+        pinThreads(false),
+        expirySweep(50),
+        latencyMetrics(true),
+        elastic(false),
+        minThreads(1),
+        maxThreads(64),
+        keepAlive(60000),
+        scaleInterval(100),
+        growQueueDepth(4),
+        growWait(50),
+        growSustain(2),
+        resizeCooldown(5000) {}
+};
+
+// 一次伸缩决策
+struct ResizeEvent {
+    std::chrono::system_clock::time_point time;
+    size_t from;                   // 调整前线程数
+    size_t to;                     // 调整后线程数
+    size_t queueDepth;             // 决策时队列长度
+    uint64_t waitMs;               // 决策时最近任务的排队时间
+    const char* reason;
+};
+
+struct ThreadPoolStats {
+    size_t liveThreads;
+    size_t activeThreads;
+    size_t peakThreads;
+    uint64_t completedTasks;
+    uint64_t growCount;
+    uint64_t shrinkCount;
+    std::vector<ResizeEvent> recentResizes;    // 最近的伸缩记录，旧的在前
+};
 
 // 线程池
 class ThreadPool {
 public:
     ThreadPool(size_t num_threads,
+        std::shared_ptr<PriorityTaskQueue> queue,
+        shared_ptr<TransCtx> ctx,
+        SchedulerMode mode = SchedulerMode::GLOBAL_QUEUE)
+        : ThreadPool(makeConfig(num_threads, mode), std::move(queue), std::move(ctx)) {}
+
+    ThreadPool(const ThreadPoolConfig& conf,
         std::shared_ptr<PriorityTaskQueue> queue,
         shared_ptr<TransCtx> ctx)
         : queue_(std::move(queue))
         , stopped_(false)
-        , ctx_(std::move(ctx)){
+        , ctx_(std::move(ctx))
+        , mode_(conf.mode)
+        , batch_size_(conf.batchSize > 0 ? conf.batchSize : 1)
+        , pin_threads_(conf.pinThreads)
+        , expiry_sweep_(conf.expirySweep)
+        , elastic_(conf.elastic && conf.mode == SchedulerMode::GLOBAL_QUEUE)
+        , min_threads_(conf.minThreads)
+        , max_threads_(std::max(conf.maxThreads, conf.minThreads))
+        , slot_limit_(std::max(conf.maxThreads, conf.minThreads))
+        , keep_alive_(conf.keepAlive)
+        , scale_interval_(conf.scaleInterval)
+        , grow_queue_depth_(conf.growQueueDepth)
+        , grow_wait_ms_(static_cast<uint64_t>(conf.growWait.count()))
+        , grow_sustain_(conf.growSustain > 0 ? conf.growSustain : 1)
+        , resize_cooldown_(conf.resizeCooldown) {
+        if (conf.elastic && !elastic_) {
+            LOG(WARN) << "Elastic sizing requires GLOBAL_QUEUE mode, using fixed "
+                      << conf.numThreads << " threads";
+        }
+        if (expiry_sweep_.count() > 0 && queue_->engine() == QueueEngine::RING) {
+            LOG(WARN) << "Expiry sweep is not supported by the RING engine, expired tasks are dropped at pop";
+            expiry_sweep_ = std::chrono::milliseconds(0);
+        }
+        size_t num_threads = conf.numThreads;
+        if (elastic_) {
+            num_threads = std::min(std::max(num_threads, min_threads_.load()), slot_limit_);
+        }
+        if (mode_ == SchedulerMode::WORK_STEALING) {
+            for (size_t i = 0; i < num_threads; ++i) {
+                local_queues_.push_back(std::make_unique<WorkStealQueue>(&in_flight_));
+            }
+        }
+        if (pin_threads_ || mode_ == SchedulerMode::NUMA_AWARE) {
+            topology_ = CpuTopology::detect();
+        }
+        if (mode_ == SchedulerMode::NUMA_AWARE) {
+            // 节点数不超过线程数，保证每个节点至少有一个工作线程；传入的队列作为 0 号节点的队列
+            const size_t nodes = std::max<size_t>(1, std::min(topology_.nodeCount(), num_threads));
+            node_queues_.push_back(queue_);
+            for (size_t i = 1; i < nodes; ++i) {
+                node_queues_.push_back(std::make_shared<PriorityTaskQueue>(
+                    queue_->fixedMaxSize(), queue_->engine(), queue_->fixedAging()));
+            }
+            node_idle_ = std::make_unique<std::atomic<size_t>[]>(nodes);
+            for (size_t i = 0; i < nodes; ++i) {
+                node_idle_[i] = 0;
+            }
+            LOG(INFO) << "NUMA-aware pool: " << nodes << " of " << topology_.nodeCount()
+                      << " nodes, " << num_threads << " threads";
+        }
+        queue_->trackInFlight(&in_flight_);
+        for (size_t i = 1; i < node_queues_.size(); ++i) {
+            node_queues_[i]->trackInFlight(&in_flight_);
+        }
+        if (conf.latencyMetrics) {
+            // 每个工作线程槽位一组直方图，弹性模式下槽位数不超过 slot_limit_
+            latency_ = std::make_unique<LatencyMetrics>(elastic_ ? slot_limit_ : num_threads);
+        }
+        live_threads_ = num_threads;
+        peak_threads_ = num_threads;
+        std::lock_guard<std::mutex> lock(workers_mutex_);
         for (size_t i = 0; i < num_threads; ++i) {
-            workers_.emplace_back([this, i]() {
-                this->workerThread(i);
+            workers_.push_back(std::make_unique<WorkerSlot>());
+            startWorker(i);
+        }
+        if (elastic_) {
+            scaler_thread_ = std::thread([this]() {
+                this->scalerThread();
             });
         }
+        maybeStartSweep();
     }
 
     ~ThreadPool() {
@@ -32,14 +186,162 @@ public:
     }
 
     void stop() {
-        stopped_ = true;
+        {
+            std::lock_guard<std::mutex> lock(timer_mutex_);
+            stopped_ = true;
+        }
+        timer_cv_.notify_all();
+        if (timer_thread_.joinable()) {
+            timer_thread_.join();
+        }
+        {
+            // 与 scaler 线程检查 stopped_ 之后、进入等待之前的窗口互斥
+            std::lock_guard<std::mutex> lock(scaler_mutex_);
+        }
+        scaler_cv_.notify_all();
+        if (scaler_thread_.joinable()) {
+            scaler_thread_.join();
+        }
         queue_->stop();
+        for (auto& node_queue : node_queues_) {
+            node_queue->stop();
+        }
 
+        // 扩容发生在 scaler 线程或 setThreadLimits 中，grow 在锁内检查 stopped_，此后不会再新增线程
+        std::lock_guard<std::mutex> lock(workers_mutex_);
         for (auto& worker : workers_) {
-            if (worker.joinable()) {
-                worker.join();
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+        // 队列可能比线程池活得长
+        queue_->trackInFlight(nullptr);
+    }
+
+    // 提交任务
+    // 工作窃取模式下，本池工作线程提交的任务进入该线程的本地队列，不受队列容量限制
+    // 其它线程提交的任务仍进入全局队列
+    // NUMA_AWARE 模式下放到提交线程所在节点
+    bool submit(Task&& task) {
+        if (mode_ == SchedulerMode::NUMA_AWARE) {
+            return submit(std::move(task), NodePlacement::LOCAL_NODE);
+        }
+        if (mode_ == SchedulerMode::WORK_STEALING && current_pool_ == this) {
+            local_queues_[current_worker_]->push(std::move(task));
+            if (idle_workers_.load() > 0) {
+                queue_->wakeWaiters();
             }
+            return true;
+        }
+        if (!queue_->push(std::move(task))) {
+            return false;
         }
+        maybeStartSweep();
+        return true;
+    }
+
+    // 按 placement 选择节点提交，仅 NUMA_AWARE 模式有区别，其它模式同 submit(task)
+    bool submit(Task&& task, NodePlacement placement) {
+        if (mode_ != SchedulerMode::NUMA_AWARE) {
+            return submit(std::move(task));
+        }
+        const size_t node = placement == NodePlacement::LOCAL_NODE ? localNode() : anyNode();
+        if (!node_queues_[node]->push(std::move(task))) {
+            return false;
+        }
+        notifyNodePush(node);
+        maybeStartSweep();
+        return true;
+    }
+
+    // 提交可调用对象，返回其结果的 future；规则同 submit
+    // 被拒绝或在队列中超时丢弃时 future 以异常完成
+    template <typename F,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    auto submit(F&& func, Priority priority = Priority::HIGH)
+        -> TaskFuture<std::invoke_result_t<std::decay_t<F>&, const shared_ptr<TransCtx>&>> {
+        using Fn = std::decay_t<F>;
+        using R = std::invoke_result_t<Fn&, const shared_ptr<TransCtx>&>;
+
+        auto state = std::make_shared<FutureState<R>>(this);
+        submit(Task([promise = TaskPromise<R>(state), fn = Fn(std::forward<F>(func))](
+            const shared_ptr<TransCtx>& ctx) mutable {
+            fulfil(promise, fn, ctx);
+        }, priority));
+        return TaskFuture<R>(std::move(state));
+    }
+
+    // 批量提交，规则同 submit，返回接收与拒绝的数量
+    BatchResult submitBatch(std::vector<Task>& tasks, std::vector<Task>* rejected_out = nullptr) {
+        if (mode_ == SchedulerMode::WORK_STEALING && current_pool_ == this) {
+            auto& local = *local_queues_[current_worker_];
+            for (auto& task : tasks) {
+                local.push(std::move(task));
+            }
+            if (!tasks.empty() && idle_workers_.load() > 0) {
+                queue_->wakeWaiters();
+            }
+            BatchResult result;
+            result.accepted = tasks.size();
+            return result;
+        }
+        if (mode_ == SchedulerMode::NUMA_AWARE) {
+            const size_t node = localNode();
+            const BatchResult result = node_queues_[node]->pushBatch(tasks, rejected_out);
+            if (result.accepted > 0) {
+                notifyNodePush(node);
+                maybeStartSweep();
+            }
+            return result;
+        }
+        const BatchResult result = queue_->pushBatch(tasks, rejected_out);
+        if (result.accepted > 0) {
+            maybeStartSweep();
+        }
+        return result;
+    }
+
+    // 延迟 delay 后以 priority 提交一次任务，返回可用于取消的句柄
+    // 到期时才创建 Task，队列超时从到期入队时算起；到期时队列已满则丢弃并记 WARN
+    TimerHandle scheduleAfter(std::chrono::milliseconds delay, Task::TaskFunc func,
+                              Priority priority = Priority::HIGH) {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        const auto now = TimerWheel::Clock::now();
+        const TimerHandle handle = timer_wheel_.addOnce(now, delay, std::move(func), priority);
+        notifyTimerLocked(now + delay);
+        return handle;
+    }
+
+    // 每隔 period 提交一次任务，首次在一个周期后；错过的周期不补
+    // 同一个可调用对象在各次触发间共享，上一次未执行完时可能被并发调用
+    TimerHandle scheduleEvery(std::chrono::milliseconds period, Task::TaskFunc func,
+                              Priority priority = Priority::HIGH) {
+        auto shared_func = std::make_shared<Task::TaskFunc>(std::move(func));
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        const auto now = TimerWheel::Clock::now();
+        const TimerHandle handle = timer_wheel_.addPeriodic(now, period, std::move(shared_func), priority);
+        notifyTimerLocked(now + period);
+        return handle;
+    }
+
+    // 取消定时器；已到期并进入队列的那一次不受影响
+    bool cancelTimer(TimerHandle handle) {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        return timer_wheel_.cancel(handle);
+    }
+
+    size_t getPendingTimers() {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        return timer_wheel_.size();
+    }
+
+    [[nodiscard]] SchedulerMode getMode() const {
+        return mode_;
+    }
+
+    // NUMA_AWARE 模式下使用的节点数，其它模式为 1
+    [[nodiscard]] size_t getNodeCount() const {
+        return node_queues_.empty() ? 1 : node_queues_.size();
     }
 
     size_t getActiveThreads() const {
@@ -50,43 +352,653 @@ public:
         return completed_tasks_.load();
     }
 
+    // 当前存活的工作线程数
+    size_t getLiveThreads() const {
+        return live_threads_.load();
+    }
+
+    // 运行中调整弹性模式的线程数上下限，上限不超过构造时的 maxThreads；非弹性模式或已停止时返回 false
+    // 低于新下限时立即补足，高于新上限的线程在执行完当前任务或取任务超时后退出
+    bool setThreadLimits(size_t min_threads, size_t max_threads) {
+        if (!elastic_ || stopped_) {
+            return false;
+        }
+        max_threads = std::min(std::max<size_t>(max_threads, 1), slot_limit_);
+        min_threads = std::min(std::max<size_t>(min_threads, 1), max_threads);
+        min_threads_ = min_threads;
+        max_threads_ = max_threads;
+        const size_t live = live_threads_.load();
+        if (live < min_threads) {
+            grow(min_threads - live, "min threads raised");
+        }
+        LOG(INFO) << "ThreadPool limits set to [" << min_threads << ", " << max_threads << "]";
+        return true;
+    }
+
+    [[nodiscard]] size_t getMinThreads() const { return min_threads_.load(); }
+    [[nodiscard]] size_t getMaxThreads() const { return max_threads_.load(); }
+
+    // 优雅停止：关闭队列准入，等待已入队与执行中的任务完成，超时返回 false
+    // 此后定时器到期的任务与工作线程内派生到全局队列的任务同样被拒绝；之后仍需调用 stop()
+    bool drain(std::chrono::milliseconds timeout) {
+        queue_->closeAdmission();
+        for (auto& node_queue : node_queues_) {
+            node_queue->closeAdmission();
+        }
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!drained()) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    // 未开启 latencyMetrics 时返回 nullptr
+    const LatencyMetrics* getLatencyMetrics() const {
+        return latency_.get();
+    }
+
+    ThreadPoolStats getStats() {
+        ThreadPoolStats stats;
+        stats.liveThreads = live_threads_.load();
+        stats.activeThreads = active_threads_.load();
+        stats.completedTasks = completed_tasks_.load();
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats.peakThreads = peak_threads_;
+        stats.growCount = grow_count_;
+        stats.shrinkCount = shrink_count_;
+        stats.recentResizes = resize_history_;
+        return stats;
+    }
+
 private:
-    void workerThread(size_t thread_id) {
+    static ThreadPoolConfig makeConfig(size_t num_threads, SchedulerMode mode) {
+        ThreadPoolConfig conf;
+        conf.numThreads = num_threads;
+        conf.mode = mode;
+        return conf;
+    }
+
+    // 工作线程槽位；弹性模式下退出的线程留在槽位中，扩容时 join 后复用
+    struct WorkerSlot {
+        std::thread thread;
+        std::atomic<bool> exited{false};
+        // 运行时统计，只由该槽位的线程写入，槽位复用时沿用
+        StatCell completed;
+        StatCell busy;
+        StatCell live;
+    };
+
+    // 调用方持有 workers_mutex_
+    void startWorker(size_t slot) {
+        WorkerSlot& worker = *workers_[slot];
+        if (worker.thread.joinable()) {
+            worker.thread.join();
+        }
+        worker.exited = false;
+        if (!worker.completed.bound()) {
+            worker.completed = ShmStats::counter("pool.completed");
+            worker.busy = ShmStats::gauge("pool.busy");
+            worker.live = ShmStats::gauge("pool.live");
+        }
+        worker.thread = std::thread([this, slot, &worker]() {
+            worker.live.set(1);
+            this->workerThread(slot, worker);
+            worker.live.set(0);
+            worker.exited = true;
+        });
+    }
+
+    void workerThread(size_t thread_id, const WorkerSlot& worker) {
         LOG(DEBUG) << "Worker thread " << thread_id << " started (PID: "
                   << getpid() << ")";
+        current_pool_ = this;
+        current_worker_ = thread_id;
+        if (pin_threads_ || mode_ == SchedulerMode::NUMA_AWARE) {
+            pinWorker(thread_id);
+        }
 
+        auto idle_since = std::chrono::steady_clock::now();
+        std::vector<Task> batch;
         while (!stopped_) {
-            auto task = queue_->pop(1000); // 1秒超时
+            if (elastic_ && retireExcess()) {
+                break;
+            }
+            // 任务也可能绕过 submit 直接写入队列
+            maybeStartSweep();
+            // 等待超时取自调度参数，运行中调整后下一轮生效
+            const int pop_timeout_ms = pollTimeoutMs();
+            if (mode_ == SchedulerMode::GLOBAL_QUEUE && batch_size_ > 1) {
+                // 一次唤醒取出多个任务，已取出的任务在停止时也会执行完
+                batch.clear();
+                queue_->popBatch(batch, batch_size_, pop_timeout_ms);
+                for (auto& task : batch) {
+                    runTask(worker, thread_id, task);
+                }
+                if (!batch.empty()) {
+                    idle_since = std::chrono::steady_clock::now();
+                } else if (tryRetire(idle_since)) {
+                    break;
+                }
+                continue;
+            }
+
+            std::optional<Task> task;
+            if (mode_ == SchedulerMode::WORK_STEALING) {
+                task = nextStealingTask(thread_id);
+            } else if (mode_ == SchedulerMode::NUMA_AWARE) {
+                task = nextNodeTask(thread_id);
+            } else {
+                task = queue_->pop(pop_timeout_ms);
+            }
 
-            if (!task) continue;
+            if (!task) {
+                if (tryRetire(idle_since)) {
+                    break;
+                }
+                continue;
+            }
+
+            runTask(worker, thread_id, *task);
+            idle_since = std::chrono::steady_clock::now();
+        }
 
-            active_threads_++;
+        LOG(DEBUG) << "Worker thread " << thread_id << " stopped";
+        current_pool_ = nullptr;
+    }
 
-            auto start = std::chrono::steady_clock::now();
-            task->execute(ctx_);
-            auto end = std::chrono::steady_clock::now();
+    // 弹性模式下缩短等待，使空闲线程能及时按 keepAlive 退出
+    int pollTimeoutMs() const {
+        const auto poll = std::max<int64_t>(SchedulerTuning::cached().workerPoll.count(), 1);
+        return static_cast<int>(elastic_ ? std::clamp<int64_t>(keep_alive_.count(), std::min<int64_t>(10, poll), poll) : poll);
+    }
 
-            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-                end - start).count();
+    void runTask(const WorkerSlot& worker, size_t thread_id, Task& task) {
+        active_threads_++;
+        worker.busy.set(1);
 
-            LOG(DEBUG) << "Thread " << thread_id << " completed task "
-                      << task->getTaskId() << " (priority: "
-                      << static_cast<int>(task->getPriority())
-                      << ", duration: " << duration << "ms)" ;
+        auto start = std::chrono::steady_clock::now();
+        if (elastic_) {
+            last_wait_ms_.store(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                start - task.getSubmitTime()).count()), std::memory_order_relaxed);
+        }
+        task.execute(ctx_);
+        auto end = std::chrono::steady_clock::now();
 
-            active_threads_--;
-            completed_tasks_++;
+        if (latency_) {
+            latency_->record(thread_id, task.getPriority(),
+                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    start - task.getSubmitTime()).count()),
+                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    end - start).count()));
         }
 
-        LOG(DEBUG) << "Worker thread " << thread_id << " stopped";
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            end - start).count();
+
+        LOG(DEBUG) << "Thread " << thread_id << " completed task "
+                  << task.getTaskId() << " (priority: "
+                  << static_cast<int>(task.getPriority())
+                  << ", duration: " << duration << "ms)" ;
+
+        worker.busy.set(0);
+        worker.completed.add();
+        active_threads_--;
+        completed_tasks_++;
+        in_flight_--;
+    }
+
+    // 首次使用定时器或启用到期清理时启动定时线程；新定时器早于当前睡眠目标时唤醒它
+    void notifyTimerLocked(TimerWheel::Clock::time_point expire) {
+        if (stopped_) {
+            return;
+        }
+        if (!timer_thread_.joinable()) {
+            timer_thread_ = std::thread([this]() {
+                this->timerThread();
+            });
+            return;
+        }
+        if (expire < timer_sleep_until_) {
+            timer_cv_.notify_one();
+        }
+    }
+
+    // 到期清理按需启动：队列设置了到期回调或入队过有截止时间的任务后才启动，空闲的池不多一个定时线程
+    void maybeStartSweep() {
+        if (expiry_sweep_.count() == 0 || sweep_started_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        const bool wanted = node_queues_.empty()
+            ? queue_->wantsSweep()
+            : std::any_of(node_queues_.begin(), node_queues_.end(),
+                          [](const std::shared_ptr<PriorityTaskQueue>& node_queue) { return node_queue->wantsSweep(); });
+        if (!wanted) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        if (!sweep_started_.exchange(true, std::memory_order_relaxed)) {
+            notifyTimerLocked(TimerWheel::Clock::now());
+        }
+    }
+
+    // 定时线程：推进时间轮，到期任务批量放入全局队列；清理启动后按 expirySweep 周期清理队列中的到期任务
+    void timerThread() {
+        std::vector<Task> fired;
+        std::unique_lock<std::mutex> lock(timer_mutex_);
+        auto next_sweep = TimerWheel::Clock::now() + expiry_sweep_;
+        while (!stopped_) {
+            const auto now = TimerWheel::Clock::now();
+            timer_wheel_.advance(now, fired);
+            if (!fired.empty()) {
+                lock.unlock();
+                const BatchResult result = queue_->pushBatch(fired);
+                if (result.rejected > 0) {
+                    LOG(WARN) << "Timer dropped " << result.rejected << " tasks, queue full";
+                }
+                if (result.accepted > 0 && mode_ == SchedulerMode::NUMA_AWARE) {
+                    notifyNodePush(0);
+                }
+                fired.clear();
+                lock.lock();
+                continue;
+            }
+            if (sweep_started_.load(std::memory_order_relaxed) && now >= next_sweep) {
+                lock.unlock();
+                sweepExpired(now);
+                lock.lock();
+                next_sweep = now + expiry_sweep_;
+                continue;
+            }
+            timer_sleep_until_ = timer_wheel_.nextWake();
+            if (sweep_started_.load(std::memory_order_relaxed)) {
+                timer_sleep_until_ = std::min(timer_sleep_until_, next_sweep);
+            }
+            if (timer_sleep_until_ == TimerWheel::Clock::time_point::max()) {
+                timer_cv_.wait(lock);
+            } else {
+                timer_cv_.wait_until(lock, timer_sleep_until_);
+            }
+            timer_sleep_until_ = TimerWheel::Clock::time_point::min();
+        }
+    }
+
+    void sweepExpired(TimerWheel::Clock::time_point now) {
+        size_t expired = 0;
+        if (node_queues_.empty()) {
+            expired = queue_->sweepExpired(now);
+        } else {
+            for (auto& node_queue : node_queues_) {
+                expired += node_queue->sweepExpired(now);
+            }
+        }
+        if (expired > 0) {
+            LOG(DEBUG) << "Swept " << expired << " expired tasks";
+        }
+    }
+
+    // 空闲超过 keepAlive 且线程数高于下限时退出；刚扩容过的冷却期内不退出
+    bool tryRetire(std::chrono::steady_clock::time_point idle_since) {
+        if (!elastic_ || stopped_) {
+            return false;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now - idle_since < keep_alive_) {
+            return false;
+        }
+        if (now.time_since_epoch().count() - last_grow_ns_.load() < std::chrono::nanoseconds(resize_cooldown_).count()) {
+            return false;
+        }
+        size_t live = live_threads_.load();
+        while (live > min_threads_.load(std::memory_order_relaxed)) {
+            if (live_threads_.compare_exchange_weak(live, live - 1)) {
+                recordResize(live, live - 1, "idle keep-alive expired");
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 上限被调低后多出的线程直接退出，不受 keepAlive 与冷却期限制
+    bool retireExcess() {
+        size_t live = live_threads_.load();
+        while (live > max_threads_.load(std::memory_order_relaxed)) {
+            if (live_threads_.compare_exchange_weak(live, live - 1)) {
+                recordResize(live, live - 1, "above max threads");
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 无任务排队且没有已出队未执行完的任务（含批量取出后尚未轮到的）
+    // 出队计数读两次：先读的一次覆盖执行中的任务结束前派生的子任务（它们在计数减少前已入队），
+    // 后读的一次覆盖扫描队列期间被取走的任务（出队时计数先于深度变化）
+    bool drained() const {
+        if (in_flight_.load() > 0 || queue_->size() > 0) {
+            return false;
+        }
+        for (const auto& node_queue : node_queues_) {
+            if (node_queue->size() > 0) {
+                return false;
+            }
+        }
+        if (!std::all_of(local_queues_.begin(), local_queues_.end(),
+                         [](const std::unique_ptr<WorkStealQueue>& local) { return local->empty(); })) {
+            return false;
+        }
+        return in_flight_.load() == 0;
+    }
+
+    // 周期检查积压与排队时间，连续 growSustain 次超过阈值才扩容
+    // 每次按积压补足线程，但最多翻倍
+    void scalerThread() {
+        size_t sustained = 0;
+        std::unique_lock<std::mutex> lock(scaler_mutex_);
+        while (!stopped_) {
+            scaler_cv_.wait_for(lock, scale_interval_);
+            if (stopped_) {
+                break;
+            }
+            const size_t live = live_threads_.load();
+            const size_t max_threads = max_threads_.load(std::memory_order_relaxed);
+            const size_t depth = queue_->size();
+            const uint64_t wait_ms = last_wait_ms_.load(std::memory_order_relaxed);
+            // 所有线程都在执行长任务时没有新的排队时间样本，按饱和处理
+            const bool pressure = depth > grow_queue_depth_ * live
+                && (wait_ms >= grow_wait_ms_ || active_threads_.load() >= live);
+            sustained = pressure ? sustained + 1 : 0;
+            if (sustained >= grow_sustain_ && live < max_threads) {
+                const size_t wanted = std::min(max_threads, (depth + grow_queue_depth_ - 1) / std::max<size_t>(grow_queue_depth_, 1));
+                const size_t step = std::min(wanted > live ? wanted - live : 1, std::max<size_t>(live, 1));
+                if (grow(step) > 0) {
+                    sustained = 0;
+                }
+            }
+        }
+    }
+
+    // 复用已退出线程的槽位或新增槽位；退出中的线程尚未让出槽位时跳过，返回实际新增数
+    size_t grow(size_t count, const char* reason = "queue backlog") {
+        std::lock_guard<std::mutex> lock(workers_mutex_);
+        if (stopped_) {
+            return 0;
+        }
+        const size_t from = live_threads_.load();
+        size_t started = 0;
+        size_t next = 0;
+        while (started < count) {
+            while (next < workers_.size() && !workers_[next]->exited) {
+                ++next;
+            }
+            if (next == workers_.size()) {
+                if (workers_.size() >= slot_limit_) {
+                    break;
+                }
+                workers_.push_back(std::make_unique<WorkerSlot>());
+            }
+            live_threads_++;
+            startWorker(next++);
+            ++started;
+        }
+        if (started > 0) {
+            last_grow_ns_ = std::chrono::steady_clock::now().time_since_epoch().count();
+            recordResize(from, from + started, reason);
+        }
+        return started;
+    }
+
+    void recordResize(size_t from, size_t to, const char* reason) {
+        ResizeEvent event;
+        event.time = std::chrono::system_clock::now();
+        event.from = from;
+        event.to = to;
+        event.queueDepth = queue_->size();
+        event.waitMs = last_wait_ms_.load(std::memory_order_relaxed);
+        event.reason = reason;
+        LOG(INFO) << "ThreadPool resize " << from << " -> " << to << " (" << reason
+                  << ", queue: " << event.queueDepth << ", wait: " << event.waitMs << "ms)";
+
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        if (to > from) {
+            ++grow_count_;
+            peak_threads_ = std::max(peak_threads_, to);
+        } else {
+            ++shrink_count_;
+        }
+        if (resize_history_.size() >= kResizeHistory) {
+            resize_history_.erase(resize_history_.begin());
+        }
+        resize_history_.push_back(event);
+    }
+
+    // 工作窃取模式取任务：全局更高优先级 > 本地 > 全局 > 窃取 > 阻塞等待
+    std::optional<Task> nextStealingTask(size_t thread_id) {
+        auto& local = *local_queues_[thread_id];
+
+        const int local_top = local.topPriority();
+        if (local_top > 0) {
+            if (local_top < static_cast<int>(Priority::CRITICAL)) {
+                if (auto task = queue_->tryPop(static_cast<Priority>(local_top + 1))) {
+                    return task;
+                }
+            }
+            Task task;
+            if (takeLocal(local, task, true)) {
+                return std::optional<Task>(std::move(task));
+            }
+        }
+        if (auto task = queue_->tryPop()) {
+            return task;
+        }
+        Task task;
+        if (steal(task, thread_id, false)) {
+            return std::optional<Task>(std::move(task));
+        }
+
+        // 先取唤醒纪元并登记空闲，再检查一次，避免与 submit 之间丢失唤醒
+        const uint64_t epoch = queue_->wakeEpoch();
+        idle_workers_++;
+        std::optional<Task> result;
+        if (steal(task, thread_id, true)) {
+            result.emplace(std::move(task));
+        } else {
+            result = queue_->pop(pollTimeoutMs(), epoch);
+        }
+        idle_workers_--;
+        return result;
+    }
+
+    size_t nodeOfWorker(size_t thread_id) const {
+        return thread_id % node_queues_.size();
+    }
+
+    // NUMA_AWARE 模式下线程按节点轮流分配；绑定单核时在节点内再按核轮流分配
+    void pinWorker(size_t thread_id) {
+        std::vector<int> cpus;
+        if (mode_ == SchedulerMode::NUMA_AWARE) {
+            const auto& node_cpus = topology_.nodes()[nodeOfWorker(thread_id)].cpus;
+            if (pin_threads_) {
+                cpus.push_back(node_cpus[(thread_id / node_queues_.size()) % node_cpus.size()]);
+            } else {
+                cpus = node_cpus;
+            }
+        } else {
+            size_t index = thread_id % topology_.cpuCount();
+            for (const auto& node : topology_.nodes()) {
+                if (index < node.cpus.size()) {
+                    cpus.push_back(node.cpus[index]);
+                    break;
+                }
+                index -= node.cpus.size();
+            }
+        }
+        if (!CpuTopology::pinCurrentThread(cpus)) {
+            LOG(WARN) << "Worker thread " << thread_id << " could not set CPU affinity";
+        }
+    }
+
+    // 提交线程所在节点：本池工作线程取其绑定节点，其它线程按当前 CPU 查找，未知时轮转
+    size_t localNode() {
+        if (current_pool_ == this) {
+            return nodeOfWorker(current_worker_);
+        }
+        const int node = topology_.nodeOfCpu(CpuTopology::currentCpu());
+        if (node < 0) {
+            return anyNode();
+        }
+        return static_cast<size_t>(node) % node_queues_.size();
+    }
+
+    size_t anyNode() {
+        const size_t n = node_queues_.size();
+        const size_t start = next_node_.fetch_add(1, std::memory_order_relaxed);
+        for (size_t k = 0; k < n; ++k) {
+            const size_t node = (start + k) % n;
+            if (node_idle_[node].load() > 0) {
+                return node;
+            }
+        }
+        return start % n;
+    }
+
+    // 节点入队后，该节点没有空闲线程时唤醒另一个有空闲线程的节点来窃取
+    void notifyNodePush(size_t node) {
+        if (node_idle_[node].load() > 0) {
+            return;
+        }
+        const size_t n = node_queues_.size();
+        for (size_t k = 1; k < n; ++k) {
+            const size_t other = (node + k) % n;
+            if (node_idle_[other].load() > 0) {
+                node_queues_[other]->wakeWaiters();
+                return;
+            }
+        }
+    }
+
+    // NUMA_AWARE 模式取任务：本节点 > 其它节点（从下一个节点起依次） > 阻塞等待本节点
+    std::optional<Task> nextNodeTask(size_t thread_id) {
+        const size_t node = nodeOfWorker(thread_id);
+        auto& local = *node_queues_[node];
+        if (auto task = local.tryPop()) {
+            return task;
+        }
+        if (auto task = stealFromNodes(node)) {
+            return task;
+        }
+
+        // 先取唤醒纪元并登记空闲，再检查一次其它节点，与 notifyNodePush 配对避免丢失唤醒
+        const uint64_t epoch = local.wakeEpoch();
+        node_idle_[node]++;
+        std::optional<Task> result = stealFromNodes(node);
+        if (!result) {
+            result = local.pop(pollTimeoutMs(), epoch);
+        }
+        node_idle_[node]--;
+        return result;
+    }
+
+    std::optional<Task> stealFromNodes(size_t node) {
+        const size_t n = node_queues_.size();
+        for (size_t k = 1; k < n; ++k) {
+            if (auto task = node_queues_[(node + k) % n]->tryPop()) {
+                return task;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // 窃取：选择本地队列最高优先级最高的线程
+    bool steal(Task& out, size_t thread_id, bool wait) {
+        const size_t n = local_queues_.size();
+        size_t victim = n;
+        int best = 0;
+        for (size_t k = 1; k < n; ++k) {
+            const size_t idx = (thread_id + k) % n;
+            const int top = local_queues_[idx]->topPriority();
+            if (top > best) {
+                best = top;
+                victim = idx;
+            }
+        }
+        if (victim == n) {
+            return false;
+        }
+        return takeLocal(*local_queues_[victim], out, wait);
+    }
+
+    // 本地队列出队：wait 为 true 时等锁，否则目标正忙即放弃；跳过的到期任务交给全局队列计数与回调
+    bool takeLocal(WorkStealQueue& local, Task& out, bool wait) {
+        std::vector<Task> expired;
+        const bool found = wait ? local.pop(out, expired) : local.steal(out, expired);
+        if (!expired.empty()) {
+            queue_->reportExpired(expired);
+        }
+        return found;
     }
 
     std::shared_ptr<TransCtx> ctx_;
-    std::vector<std::thread> workers_;
+    std::mutex workers_mutex_;
+    std::vector<std::unique_ptr<WorkerSlot>> workers_;
     std::shared_ptr<PriorityTaskQueue> queue_;
     std::atomic<bool> stopped_;
     std::atomic<size_t> active_threads_{0};
+    // 已从任一队列取出、尚未执行完的任务数，由队列在出队临界区内增加，drain 据此判断
+    std::atomic<size_t> in_flight_{0};
     std::atomic<uint64_t> completed_tasks_{0};
+    std::unique_ptr<LatencyMetrics> latency_;
+    SchedulerMode mode_;
+    size_t batch_size_;
+    std::vector<std::unique_ptr<WorkStealQueue>> local_queues_;
+    std::atomic<size_t> idle_workers_{0};
+
+    bool pin_threads_;
+    std::chrono::milliseconds expiry_sweep_;
+    std::atomic<bool> sweep_started_{false};    // 只在 timer_mutex_ 内置位
+    CpuTopology topology_;
+    std::vector<std::shared_ptr<PriorityTaskQueue>> node_queues_;
+    std::unique_ptr<std::atomic<size_t>[]> node_idle_;
+    std::atomic<size_t> next_node_{0};
+
+    std::mutex timer_mutex_;
+    std::condition_variable timer_cv_;
+    std::thread timer_thread_;
+    TimerWheel timer_wheel_;
+    TimerWheel::Clock::time_point timer_sleep_until_ = TimerWheel::Clock::time_point::min();
+
+    static constexpr size_t kResizeHistory = 64;
+    const bool elastic_;
+    // 可由 setThreadLimits 调整，slot_limit_ 为构造时的上限，也是工作线程槽位数的上限
+    std::atomic<size_t> min_threads_;
+    std::atomic<size_t> max_threads_;
+    const size_t slot_limit_;
+    const std::chrono::milliseconds keep_alive_;
+    const std::chrono::milliseconds scale_interval_;
+    const size_t grow_queue_depth_;
+    const uint64_t grow_wait_ms_;
+    const size_t grow_sustain_;
+    const std::chrono::milliseconds resize_cooldown_;
+    std::atomic<size_t> live_threads_{0};
+    std::atomic<uint64_t> last_wait_ms_{0};
+    std::atomic<int64_t> last_grow_ns_{0};
+    std::mutex scaler_mutex_;
+    std::condition_variable scaler_cv_;
+    std::thread scaler_thread_;
+    std::mutex stats_mutex_;
+    size_t peak_threads_ = 0;
+    uint64_t grow_count_ = 0;
+    uint64_t shrink_count_ = 0;
+    std::vector<ResizeEvent> resize_history_;
+
+    inline static thread_local ThreadPool* current_pool_ = nullptr;
+    inline static thread_local size_t current_worker_ = 0;
 };
 
+inline bool submitToPool(ThreadPool* pool, Task&& task) {
+    return pool->submit(std::move(task));
+}
+
 #endif //FRAME_THREADPOOL_H
\ No newline at end of file
@@ -0,0 +1,294 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_TIMERWHEEL_H
+#define FRAME_TIMERWHEEL_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "TaskQueue.h"
+
+using namespace std;
+
+// 定时器句柄，用于取消；generation 防止槽位复用后误取消
+struct TimerHandle {
+    uint32_t index;
+    uint32_t generation;
+
+    TimerHandle() : index(UINT32_MAX), generation(0) {}
+    TimerHandle(uint32_t idx, uint32_t gen) : index(idx), generation(gen) {}
+
+    [[nodiscard]] bool valid() const { return index != UINT32_MAX; }
+};
+
+// 分层时间轮：4 层 x 256 槽，精度 1ms，最远约 49 天
+// 插入、取消 O(1)；推进时每跨过一层的边界把上一层的一个槽位下放到下一层
+// 非线程安全，由调用方加锁
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using PeriodicFunc = std::shared_ptr<Task::TaskFunc>;
+
+    static constexpr size_t kLevels = 4;
+    static constexpr size_t kSlotBits = 8;
+    static constexpr size_t kSlots = 1 << kSlotBits;
+    static constexpr uint64_t kSlotMask = kSlots - 1;
+
+    explicit TimerWheel(Clock::time_point start = Clock::now())
+        : start_(start)
+        , current_(0)
+        , free_head_(kNil)
+        , size_(0)
+        , level0_bits_{} {
+        for (auto& level : heads_) {
+            level.fill(kNil);
+        }
+    }
+
+    TimerWheel(const TimerWheel &) = delete;
+    void operator=(const TimerWheel &) = delete;
+
+    // 一次性定时器
+    TimerHandle addOnce(Clock::time_point now, std::chrono::milliseconds delay,
+                        Task::TaskFunc func, Priority priority) {
+        const uint32_t idx = allocNode();
+        TimerNode& node = nodes_[idx];
+        node.func = std::move(func);
+        node.period = 0;
+        node.priority = priority;
+        insert(idx, toTick(now) + ticksOf(delay));
+        return {idx, node.generation};
+    }
+
+    // 周期定时器，首次在一个周期后触发
+    TimerHandle addPeriodic(Clock::time_point now, std::chrono::milliseconds period,
+                            PeriodicFunc func, Priority priority) {
+        const uint32_t idx = allocNode();
+        TimerNode& node = nodes_[idx];
+        node.periodic = std::move(func);
+        node.period = std::max<uint64_t>(1, ticksOf(period));
+        node.priority = priority;
+        insert(idx, toTick(now) + node.period);
+        return {idx, node.generation};
+    }
+
+    bool cancel(TimerHandle handle) {
+        if (!handle.valid() || handle.index >= nodes_.size()) {
+            return false;
+        }
+        TimerNode& node = nodes_[handle.index];
+        if (!node.active || node.generation != handle.generation) {
+            return false;
+        }
+        unlink(handle.index);
+        freeNode(handle.index);
+        return true;
+    }
+
+    // 推进到 now，把到期的任务追加到 out
+    void advance(Clock::time_point now, std::vector<Task>& out) {
+        const uint64_t target = toTick(now);
+        if (size_ == 0) {
+            current_ = std::max(current_, target);
+            return;
+        }
+        while (current_ < target && size_ > 0) {
+            ++current_;
+            if ((current_ & kSlotMask) == 0) {
+                cascade();
+            }
+            expireSlot(current_ & kSlotMask, out);
+        }
+        if (current_ < target) {
+            current_ = target;
+        }
+    }
+
+    // 下一次需要推进的时间：第 0 层最近的非空槽，或第 0 层绕回（需要下放）的时刻
+    [[nodiscard]] Clock::time_point nextWake() const {
+        if (size_ == 0) {
+            return Clock::time_point::max();
+        }
+        const uint64_t cur = current_ & kSlotMask;
+        for (uint64_t slot = cur + 1; slot < kSlots; ++slot) {
+            const uint64_t word = level0_bits_[slot >> 6] >> (slot & 63);
+            if (word == 0) {
+                slot = (slot | 63);
+                continue;
+            }
+            slot += static_cast<uint64_t>(__builtin_ctzll(word));
+            return toTime(current_ - cur + slot);
+        }
+        return toTime((current_ | kSlotMask) + 1);
+    }
+
+    [[nodiscard]] size_t size() const { return size_; }
+
+private:
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    struct TimerNode {
+        uint64_t expire = 0;
+        uint64_t period = 0;           // 0 表示一次性
+        uint32_t prev = kNil;
+        uint32_t next = kNil;
+        uint32_t generation = 0;
+        uint16_t slot = 0;             // level * kSlots + index
+        bool active = false;
+        Priority priority = Priority::HIGH;
+        Task::TaskFunc func;           // 一次性定时器的任务
+        PeriodicFunc periodic;         // 周期定时器的任务，每次触发共享
+    };
+
+    static uint64_t ticksOf(std::chrono::milliseconds ms) {
+        return ms.count() > 0 ? static_cast<uint64_t>(ms.count()) : 0;
+    }
+
+    [[nodiscard]] uint64_t toTick(Clock::time_point tp) const {
+        if (tp <= start_) {
+            return 0;
+        }
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(tp - start_).count());
+    }
+
+    [[nodiscard]] Clock::time_point toTime(uint64_t tick) const {
+        return start_ + std::chrono::milliseconds(tick);
+    }
+
+    uint32_t allocNode() {
+        uint32_t idx;
+        if (free_head_ != kNil) {
+            idx = free_head_;
+            free_head_ = nodes_[idx].next;
+        } else {
+            idx = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+        nodes_[idx].active = true;
+        ++size_;
+        return idx;
+    }
+
+    void freeNode(uint32_t idx) {
+        TimerNode& node = nodes_[idx];
+        node.active = false;
+        ++node.generation;
+        node.func.reset();
+        node.periodic.reset();
+        node.prev = kNil;
+        node.next = free_head_;
+        free_head_ = idx;
+        --size_;
+    }
+
+    // 按距当前的 tick 数选择层级；已过期的放到下一个 tick
+    void insert(uint32_t idx, uint64_t expire) {
+        if (expire <= current_) {
+            expire = current_ + 1;
+        }
+        place(idx, expire);
+    }
+
+    void place(uint32_t idx, uint64_t expire) {
+        static constexpr uint64_t kMaxDelta = (uint64_t(1) << (kSlotBits * kLevels)) - 1;
+        uint64_t delta = expire - current_;
+        if (delta > kMaxDelta) {
+            delta = kMaxDelta;
+            expire = current_ + delta;
+        }
+        size_t level = 0;
+        while (level + 1 < kLevels && delta >= (uint64_t(1) << (kSlotBits * (level + 1)))) {
+            ++level;
+        }
+        const size_t slot = (expire >> (kSlotBits * level)) & kSlotMask;
+
+        TimerNode& node = nodes_[idx];
+        node.expire = expire;
+        node.slot = static_cast<uint16_t>(level * kSlots + slot);
+        node.prev = kNil;
+        node.next = heads_[level][slot];
+        if (node.next != kNil) {
+            nodes_[node.next].prev = idx;
+        }
+        heads_[level][slot] = idx;
+        if (level == 0) {
+            level0_bits_[slot >> 6] |= uint64_t(1) << (slot & 63);
+        }
+    }
+
+    void unlink(uint32_t idx) {
+        TimerNode& node = nodes_[idx];
+        const size_t level = node.slot / kSlots;
+        const size_t slot = node.slot % kSlots;
+        if (node.prev != kNil) {
+            nodes_[node.prev].next = node.next;
+        } else {
+            heads_[level][slot] = node.next;
+        }
+        if (node.next != kNil) {
+            nodes_[node.next].prev = node.prev;
+        }
+        if (level == 0 && heads_[0][slot] == kNil) {
+            level0_bits_[slot >> 6] &= ~(uint64_t(1) << (slot & 63));
+        }
+    }
+
+    // 第 0 层绕回时，从高层往低层依次下放当前槽位
+    void cascade() {
+        size_t top = 1;
+        while (top + 1 < kLevels && ((current_ >> (kSlotBits * top)) & kSlotMask) == 0) {
+            ++top;
+        }
+        for (size_t level = top; level >= 1; --level) {
+            const size_t slot = (current_ >> (kSlotBits * level)) & kSlotMask;
+            uint32_t idx = heads_[level][slot];
+            heads_[level][slot] = kNil;
+            while (idx != kNil) {
+                const uint32_t next = nodes_[idx].next;
+                place(idx, nodes_[idx].expire);
+                idx = next;
+            }
+        }
+    }
+
+    void expireSlot(size_t slot, std::vector<Task>& out) {
+        uint32_t idx = heads_[0][slot];
+        heads_[0][slot] = kNil;
+        level0_bits_[slot >> 6] &= ~(uint64_t(1) << (slot & 63));
+        while (idx != kNil) {
+            TimerNode& node = nodes_[idx];
+            const uint32_t next = node.next;
+            if (node.period == 0) {
+                // 触发时才创建 Task，提交时间与超时从入队时刻算起
+                out.emplace_back(std::move(node.func), node.priority);
+                freeNode(idx);
+            } else {
+                out.emplace_back([fn = node.periodic](const shared_ptr<TransCtx>& ctx) {
+                    (*fn)(ctx);
+                }, node.priority);
+                uint64_t expire = node.expire + node.period;
+                if (expire <= current_) {
+                    // 错过的周期不补
+                    expire = current_ + node.period;
+                }
+                place(idx, expire);
+            }
+            idx = next;
+        }
+    }
+
+    Clock::time_point start_;
+    uint64_t current_;
+    std::vector<TimerNode> nodes_;
+    uint32_t free_head_;
+    size_t size_;
+    std::array<std::array<uint32_t, kSlots>, kLevels> heads_;
+    std::array<uint64_t, kSlots / 64> level0_bits_;
+};
+
+#endif //FRAME_TIMERWHEEL_H
@@ -0,0 +1,93 @@
+//
+// Created by agent on 2026/10/16.
+//
+
+#ifndef FRAME_WORKSTEALQUEUE_H
+#define FRAME_WORKSTEALQUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "TaskQueue.h"
+
+using namespace std;
+
+// 工作窃取模式下每个工作线程的本地队列
+// 仍按优先级分桶，锁只在本线程与窃取者之间竞争，不再全局争用
+// 出队时跳过到期任务，移入 expired，由调用方在锁外交给全局队列的 reportExpired 统一处理
+class WorkStealQueue {
+public:
+    // in_flight 见 PriorityTaskQueue::trackInFlight，取出任务时在锁内加 1
+    explicit WorkStealQueue(std::atomic<size_t>* in_flight = nullptr) : top_(0), in_flight_(in_flight) {}
+
+    WorkStealQueue(const WorkStealQueue &) = delete;
+    void operator=(const WorkStealQueue &) = delete;
+
+    void push(Task&& task) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lanes_.push(std::move(task));
+        updateTop();
+    }
+
+    // 本线程取任务
+    bool pop(Task& out, std::vector<Task>& expired) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return take(out, expired);
+    }
+
+    // 其它线程窃取，目标正忙时直接放弃，换下一个目标
+    bool steal(Task& out, std::vector<Task>& expired) {
+        std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return false;
+        }
+        return take(out, expired);
+    }
+
+    // 无锁读取当前最高优先级，0 表示为空，供窃取者挑选目标
+    // 与 ThreadPool 的空闲登记构成 Dekker 式同步，需要 seq_cst
+    [[nodiscard]] int topPriority() const {
+        return top_.load();
+    }
+
+    [[nodiscard]] bool empty() const {
+        return topPriority() == 0;
+    }
+
+private:
+    // 调用方持有 mutex_；出队计数先于 top_ 更新，窃取者与排空检查看到队列变空时计数已经加上
+    bool take(Task& out, std::vector<Task>& expired) {
+        std::chrono::steady_clock::time_point now;
+        bool have_now = false;
+        bool found = false;
+        while (!found && lanes_.pop(out)) {
+            if (!have_now) {
+                now = std::chrono::steady_clock::now();
+                have_now = true;
+            }
+            if (out.isExpired(now)) {
+                expired.push_back(std::move(out));
+                continue;
+            }
+            found = true;
+            if (in_flight_ != nullptr) {
+                in_flight_->fetch_add(1);
+            }
+        }
+        updateTop();
+        return found;
+    }
+
+    void updateTop() {
+        top_.store(lanes_.empty() ? 0 : static_cast<int>(lanes_.topPriority()));
+    }
+
+    std::mutex mutex_;
+    TaskLanes lanes_;
+    std::atomic<int> top_;
+    std::atomic<size_t>* const in_flight_;
+};
+
+#endif //FRAME_WORKSTEALQUEUE_H
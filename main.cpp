@@ -7,39 +7,246 @@
 #include "TaskQueue.h"
 #include "ThreadPool.h"
 #include <iostream>
+#include <iomanip>
+#include <thread>
 #include <CommentCtrl.h>
+#include <ShmStats.h>
+#include <ShmTaskChannel.h>
+#include <Prefork.h>
 
 using namespace std;
 
 ConfLoad* ConfLoad::conf_load_= nullptr;;
 string ConfLoad::conf_dir_ = "/Volumes/WD_BLACK/Coding/Frame/conf/framejk.conf";
 SpdLogger* SpdLogger::instance = nullptr;
-string tmp_path = "/Volumes/WD_BLACK/Coding/Frame/tmp/share_data";
+CommentCtrl* CommentCtrl::comment_ctrl_ = nullptr;
 
-int main(const int argc, char** argv) {
-    //
-    InitConf();
-    // 创建共享内存实例
-    CreateShare<CtrlShared> shm1(1, OWN_RW_OTH_RW, tmp_path);
-    CreateShare<CtrlShared> shm2(2, OWN_RW_OTH_RW, tmp_path);
-
-    CtrlShared* data1 = shm1.get();
-    data1->running = true;
-    cout << data1->running << endl;
-    data1->running = false;
-    cout << data1->running << endl;
-    CtrlShared* data2 = shm1.get();
-    data2 = shm2.get();
-    data2->running = true;
-    cout << data2->running << endl;
-    data2->running = false;
-    cout << data2->running << endl;
-
-    // if (argc < 2) {
-    //     std::cout << "Usage: " << argv[0] << " [-start|-stop|-set key value]" << std::endl;
-    //     return 1;
-    // }
+// 只读附加运行中进程的统计段，每隔 interval_ms 打印一次，计数附带每秒速率；rounds 为 0 时一直打印
+static int ShowStats(int interval_ms, int rounds) {
+    CreateShare<StatsSegment> share(kStatsShareId, OWN_RW_OTH_R, StatsSharePath(), StatsShareOptions(true));
+    if (!share.valid()) {
+        cerr << "No stats segment under " << StatsSharePath() << ", is the process running with stats.enabled?" << endl;
+        return 1;
+    }
+    const StatsSegment& segment = *share.get();
+    std::map<string, StatSample> last;
+    auto last_time = std::chrono::steady_clock::now();
+    for (int round = 0; rounds == 0 || round < rounds; ++round) {
+        if (round > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+        }
+        const auto now = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(now - last_time).count();
+        const auto stats = ShmStats::collect(segment);
+        const auto owner = static_cast<pid_t>(segment.ownerPid.load(std::memory_order_acquire));
+        cout << "pid " << owner << (kill(owner, 0) == 0 ? "" : " (exited)") << endl;
+        cout << left << setw(24) << "name" << right << setw(16) << "value" << setw(14) << "rate/s"
+             << setw(9) << "writers" << endl;
+        for (const auto& [name, sample] : stats) {
+            cout << left << setw(24) << name << right << setw(16) << sample.value;
+            const auto previous = last.find(name);
+            if (sample.kind == StatKind::COUNTER && previous != last.end() && seconds > 0) {
+                // 槽位释放后累计值可能回落，此时不计速率
+                const uint64_t delta = sample.value >= previous->second.value ? sample.value - previous->second.value : 0;
+                cout << setw(14) << fixed << setprecision(1) << static_cast<double>(delta) / seconds;
+            } else {
+                cout << setw(14) << "-";
+            }
+            cout << setw(9) << sample.writers << endl;
+        }
+        cout << endl;
+        last = stats;
+        last_time = now;
+    }
+    return 0;
+}
 
+// 任务通道上收到的任务，业务处理按 type 分派，这里只记录
+static void HandleTask(uint32_t type, std::string_view payload, const shared_ptr<TransCtx>&) {
+    LOG(DEBUG) << "Task type " << type << ", " << payload.size() << " bytes";
+}
 
-    return 0;
-}
\ No newline at end of file
+// 当前可调参数，-ping 时显示
+static string DescribeSettings(const ThreadPool& pool) {
+    return "pool.minThreads=" + std::to_string(pool.getMinThreads())
+           + " pool.maxThreads=" + std::to_string(pool.getMaxThreads())
+           + " pool.liveThreads=" + std::to_string(pool.getLiveThreads());
+}
+
+static bool ApplyLogLevel(const string& value, string& message) {
+    if (value != "DEBUG" && value != "INFO" && value != "WARN" && value != "ERROR" && value != "FATAL") {
+        message = "level must be DEBUG, INFO, WARN, ERROR or FATAL";
+        return false;
+    }
+    SpdLogger::GetInstance()->setMinLevel(stringToLogLevel(value));
+    message = "logger.minLevel=" + value;
+    return true;
+}
+
+// -set 的处理，在控制监听线程中执行
+static bool ApplySetting(ThreadPool& pool, const string& key, const string& value, string& message) {
+    if (key == "logger.minLevel") {
+        return ApplyLogLevel(value, message);
+    }
+    if (key != "pool.threads" && key != "pool.minThreads" && key != "pool.maxThreads") {
+        message = "unknown key " + key;
+        return false;
+    }
+    char* end = nullptr;
+    const long count = strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || count < 1) {
+        message = key + " must be a positive integer";
+        return false;
+    }
+    const auto threads = static_cast<size_t>(count);
+    bool ok;
+    if (key == "pool.threads") {
+        ok = pool.setThreadLimits(threads, threads);
+    } else if (key == "pool.minThreads") {
+        ok = pool.setThreadLimits(threads, std::max(threads, pool.getMaxThreads()));
+    } else {
+        ok = pool.setThreadLimits(std::min(threads, pool.getMinThreads()), threads);
+    }
+    if (!ok) {
+        message = "pool is not resizable";
+        return false;
+    }
+    message = DescribeSettings(pool);
+    return true;
+}
+
+// 线程模式：本进程消费任务通道，弹性线程池执行
+// 停止顺序：停止从通道取任务，关闭队列准入并在 ctrl.drainTimeoutMs 内等待已入队与执行中的任务完成，停止线程池，刷新日志，回复 -stop 后退出
+static int ServeThreaded(CommentCtrl& ctrl) {
+    auto queue = make_shared<PriorityTaskQueue>();
+    ThreadPool pool(PoolConfig(), queue, make_shared<TransCtx>());
+    ShmTaskConsumer consumer(ChannelId(), queue, HandleTask, ChannelSharePath(), ChannelHugePages());
+    ctrl.listen([&pool, &ctrl](const string& key, const string& value, string& message) {
+        if (!ApplySetting(pool, key, value, message)) {
+            return false;
+        }
+        ctrl.publishConfig(DescribeSettings(pool));
+        return true;
+    });
+    ctrl.publishConfig(DescribeSettings(pool));
+    consumer.start();
+    LOG(INFO) << "FrameJK started, pid " << getpid();
+
+    ctrl.waitForStop();
+    // 先停消费者：它把已从通道取出的记录推入队列后才返回，之后 drain 关闭准入
+    consumer.stop();
+    const uint64_t lost = consumer.dropped();
+    const auto timeout = CtrlDrainTimeout();
+    const bool drained = pool.drain(timeout);
+    const size_t left = queue->size();
+    pool.stop();
+    string message = drained ? "drained" : "drain timed out after " + std::to_string(timeout.count())
+                                           + " ms, " + std::to_string(left) + " queued tasks dropped";
+    if (lost > 0) {
+        message += ", " + std::to_string(lost) + " channel tasks dropped before queueing";
+    }
+    const bool clean = drained && lost == 0;
+    LOG(INFO) << "FrameJK stopping: " << message;
+    SpdLogger::GetInstance()->flush();
+    ctrl.finishStop(clean, message);
+    return clean ? 0 : 1;
+}
+
+// 预派生模式：本进程只做监管，工作进程消费任务通道；-set 只支持 logger.minLevel，经控制段下发给工作进程
+// 停止时各工作进程停止取任务并在 ctrl.drainTimeoutMs 内排空后退出
+static int ServePrefork(CommentCtrl& ctrl, PreforkMaster& master) {
+    ctrl.listen([&ctrl](const string& key, const string& value, string& message) {
+        if (key != "logger.minLevel") {
+            message = key.rfind("pool.", 0) == 0 ? "pool size is fixed in prefork mode" : "unknown key " + key;
+            return false;
+        }
+        if (!ApplyLogLevel(value, message)) {
+            return false;
+        }
+        ctrl.shared()->workerLogLevel.store(static_cast<int32_t>(stringToLogLevel(value)), std::memory_order_relaxed);
+        return true;
+    });
+    bool clean = master.start();
+    if (clean) {
+        LOG(INFO) << "FrameJK started in prefork mode, pid " << getpid();
+        // 工作进程的心跳与负载随时变化，-ping 看到的是最近一秒内的状态
+        do {
+            ctrl.publishConfig(master.describe());
+        } while (!ctrl.waitForStop(std::chrono::seconds(1)));
+    }
+    clean = master.stop() && clean;
+    const string message = clean ? "workers drained" : "some workers failed to drain or start";
+    LOG(INFO) << "FrameJK stopping: " << message;
+    SpdLogger::GetInstance()->flush();
+    ctrl.finishStop(clean, message);
+    return clean ? 0 : 1;
+}
+
+// -start：前台运行直到 -stop 或 SIGTERM/SIGINT，prefork.workers 大于 0 时以预派生模式运行
+// 控制段与预派生的 zygote 在任何线程之前建立，之后才做会写日志、起线程的初始化（InitConf 中除日志配置外的部分）
+// 工作进程由 zygote fork，这些初始化在工作进程中补做
+static int Serve(CommentCtrl& ctrl) {
+    InitLogger();
+    if (!ctrl.open()) {
+        return 1;
+    }
+    const PreforkConfig prefork = LoadPreforkConfig();
+    std::unique_ptr<PreforkMaster> master;
+    if (prefork.workers > 0) {
+        master = std::make_unique<PreforkMaster>(prefork, *ctrl.shared(), HandleTask, []() {
+            InitScheduler();
+            AttachStats();
+        });
+        if (!master->prepare()) {
+            ctrl.finishStop(false, "prefork zygote failed to start");
+            return 1;
+        }
+    }
+    InitScheduler();
+    InitHotReload();
+    InitStats();
+    return master ? ServePrefork(ctrl, *master) : ServeThreaded(ctrl);
+}
+
+int main(const int argc, char** argv) {
+    const string command = argc >= 2 ? argv[1] : "";
+    if (command == "-start") {
+        return Serve(*CommentCtrl::GetInstance(CtrlPidPath(), CtrlSharePath()));
+    }
+    // 客户端命令只读取各自用到的配置键，不建立调度参数与热加载，不碰服务进程的日志文件
+    InitClientLogger();
+    // 编译配置快照：FrameJK -compile [输出路径]，之后启动时直接映射快照
+    if (command == "-compile") {
+        string error;
+        const string out = argc >= 3 ? argv[2] : ConfLoad::snapshotPath();
+        if (!ConfLoad::GetInstance()->compile(error, out)) {
+            cerr << "Compile failed: " << error << endl;
+            return 1;
+        }
+        cout << "Compiled " << out << endl;
+        return 0;
+    }
+    // 查看运行中进程的统计：FrameJK -stats [间隔毫秒] [次数]
+    if (command == "-stats") {
+        const int interval_ms = argc >= 3 ? std::max(atoi(argv[2]), 100) : 1000;
+        const int rounds = argc >= 4 ? std::max(atoi(argv[3]), 0) : 0;
+        return ShowStats(interval_ms, rounds);
+    }
+    CommentCtrl* ctrl = CommentCtrl::GetInstance(CtrlPidPath(), CtrlSharePath());
+    if (command == "-stop" || command == "-ping" || (command == "-set" && argc >= 4)) {
+        string reply;
+        bool ok;
+        if (command == "-stop") {
+            // 等待时长留出排空之外的余量
+            ok = ctrl->stop(reply, CtrlDrainTimeout() + std::chrono::seconds(5));
+        } else if (command == "-ping") {
+            ok = ctrl->ping(reply);
+        } else {
+            ok = ctrl->set(argv[2], argv[3], reply);
+        }
+        (ok ? cout : cerr) << (ok ? "ok" : "failed") << (reply.empty() ? "" : ": " + reply) << endl;
+        return ok ? 0 : 1;
+    }
+    CommentCtrl::help(argv[0]);
+    return 1;
+}
@@ -2,6 +2,7 @@
 // Created by Yu Xin on 2025/10/18.
 //
 #include <HttpRequest.h>
+#include <ShmStats.h>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -16,6 +17,21 @@ public:
     int globalTimeout = 30;
     mutex mutex_;
     unordered_map<string, bool> cancelFlags; // 取消标志
+
+    // 运行时统计，请求在各自的线程中完成，计数用原子加
+    StatCell requests = ShmStats::counter("http.requests");
+    StatCell failed = ShmStats::counter("http.failed");
+    StatCell bytes = ShmStats::counter("http.bytes");
+    StatCell inflight = ShmStats::gauge("http.inflight");
+
+    void recordResult(const TransCtx& ctx, const HttpResponse& response) {
+        inflight.fetchSub();
+        requests.fetchAdd();
+        bytes.fetchAdd(ctx.transferredBytes);
+        if (!response.isSuccess()) {
+            failed.fetchAdd();
+        }
+    }
     
     void addCancelFlag(const string& requestId) {
         lock_guard<mutex> lock(mutex_);
@@ -54,6 +70,7 @@ void HttpRequest::sendAsync(const HttpRequestConfig& config,
         HttpResponse response;
 
         pImpl->addCancelFlag(ctx.responseCtx);
+        pImpl->inflight.fetchAdd();
 
         try {
             // 执行请求
@@ -64,21 +81,18 @@ void HttpRequest::sendAsync(const HttpRequestConfig& config,
                 response.status = HttpStatus::CANCELLED;
                 response.errorMessage = "Request was cancelled";
             }
-
-            ctx.endTime = std::chrono::system_clock::now();
-
-            // 调用完成回调
-            if (completionCallback) {
-                completionCallback(ctx, response, true);
-            }
         } catch (const std::exception& e) {
             response.status = HttpStatus::FAILED;
             response.errorMessage = e.what();
-            ctx.endTime = std::chrono::system_clock::now();
+        }
 
-            if (completionCallback) {
-                completionCallback(ctx, response, true);
-            }
+        // 每个请求只计数一次，回调抛出的异常不再回到上面的 catch
+        ctx.endTime = std::chrono::system_clock::now();
+        pImpl->recordResult(ctx, response);
+
+        // 调用完成回调
+        if (completionCallback) {
+            completionCallback(ctx, response, true);
         }
 
         pImpl->removeCancelFlag(ctx.requestId);
@@ -90,6 +104,7 @@ HttpResponse HttpRequest::sendSync(const HttpRequestConfig& config) {
     HttpResponse response;
 
     pImpl->addCancelFlag(ctx.requestId);
+    pImpl->inflight.fetchAdd();
 
     try {
         executeRequest(ctx, config, response);
@@ -104,6 +119,7 @@ HttpResponse HttpRequest::sendSync(const HttpRequestConfig& config) {
     }
 
     ctx.endTime = std::chrono::system_clock::now();
+    pImpl->recordResult(ctx, response);
     pImpl->removeCancelFlag(ctx.requestId);
 
     return response;
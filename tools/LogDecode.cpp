@@ -0,0 +1,35 @@
+//
+// Created by agent on 2026/10/16.
+//
+// 把二进制日志（LoggerConfig::binaryMode）解码为文本日志格式，输出到标准输出
+// 用法: LogDecode <file> [file...]
+// 滚动后的文件按从旧到新的顺序给出，例如 LogDecode framejk.log.bin.2 framejk.log.bin.1 framejk.log.bin
+//
+
+#include <cstdio>
+#include <string>
+#include "BinaryLog.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <file> [file...]\n", argv[0]);
+        return 1;
+    }
+    int status = 0;
+    string line;
+    for (int i = 1; i < argc; ++i) {
+        BinaryLogReader reader(argv[i]);
+        if (!reader.valid()) {
+            fprintf(stderr, "%s: not a binary log file\n", argv[i]);
+            status = 1;
+            continue;
+        }
+        while (reader.next(line)) {
+            fwrite(line.data(), 1, line.size(), stdout);
+            fputc('\n', stdout);
+        }
+    }
+    return status;
+}